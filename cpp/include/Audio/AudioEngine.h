@@ -7,7 +7,11 @@
 #include "DSP/Filter.h"
 #include "DSP/Delay.h"
 #include "DSP/Reverb.h"
+#include "DSP/EffectChain.h"
 #include "Audio/AudioFilePlayer.h"
+#include "Audio/PresetBank.h"
+#include "Audio/SampleConverter.h"
+#include "Audio/Sampler.h"
 #include <memory>
 #include <mutex>
 
@@ -21,11 +25,127 @@ enum class AudioMode {
     MP3Playback     // MP3 file playback mode
 };
 
+/**
+ * Order of the time-based effects in the processing chain.
+ */
+enum class EffectOrder {
+    DelayThenReverb,  // Echoes feed the spring tank (classic dub)
+    ReverbThenDelay   // Reverberated signal gets echoed
+};
+
+/**
+ * Note event sent from control threads to the audio thread.
+ * The timestamp (monotonicNanos()) decides the sample offset at which the
+ * event takes effect inside the next rendered block.
+ */
+struct NoteEvent {
+    enum class Type : uint8_t {
+        Trigger,
+        Release,
+        Sample      // Start one-shot sample number `sample`
+    };
+
+    Type type;
+    int64_t timestampNs;
+    int sample = 0;
+};
+
+/**
+ * Morph between two parameter snapshots A and B.
+ *
+ * Prepared on the control side as a base (A) and a delta (B - A) per lane,
+ * derived coefficients included, so the audio thread only evaluates
+ * base + position * delta. Lanes are listed in AudioEngine.cpp
+ * (forEachMorphLane).
+ */
+struct MorphParameters {
+    static constexpr int NUM_LANES = 12 + ReverbEffect::NUM_SPRINGS + 5;
+
+    bool enabled = false;
+    float position = 0.0f;  // 0 = A, 1 = B
+    std::array<float, NUM_LANES> base{};
+    std::array<float, NUM_LANES> delta{};
+};
+
+/**
+ * Complete set of engine parameters handed from control threads to the
+ * audio thread as one consistent snapshot.
+ *
+ * Each DSP block carries its own derived coefficients, computed by the
+ * control thread (prepareParameters()) before publishing, so the audio
+ * thread only copies values at the start of a block.
+ */
+struct EngineParameters {
+    float volume = 0.7f;
+    float baseFrequency = 440.0f;
+    float lfoPitchDepth = 0.0f;  // LFO pitch modulation depth (octaves)
+    PitchEnvelopeMode pitchEnvMode = PitchEnvelopeMode::Up;
+    Waveform oscWaveform = Waveform::Sine;
+
+    // Effect chain layout
+    EffectOrder effectOrder = EffectOrder::DelayThenReverb;
+    bool filterEnabled = false;
+    bool delayEnabled = true;
+    bool reverbEnabled = true;
+    float filterCutoff = 3000.0f;
+    float filterResonance = 1.0f;
+    float inputGain = 1.0f;  // Full-duplex line input level
+    float sampleGain = 1.0f; // One-shot sample level
+    float samplePitch = 1.0f; // One-shot playback rate (before pitch envelope/LFO)
+    float sampleStretch = 1.0f;        // One-shot duration factor at the same pitch
+    bool sampleStretchToDelay = false; // Stretch each one-shot to the delay time instead
+
+    // Bumped by applyPreset(); the audio thread crossfades into a snapshot
+    // whose serial differs from the one it is playing
+    uint32_t crossfadeSerial = 0;
+
+    // While enabled, overrides the morphed parameters
+    MorphParameters morph;
+
+    Envelope::Parameters envelope;
+    LFO::Parameters lfo;
+    DelayEffect::Parameters delay;
+    ReverbEffect::Parameters reverb;
+};
+
+/**
+ * A block of captured audio for full-duplex (FX unit) mode, referenced in
+ * place, e.g. straight from the capture mmap area.
+ */
+struct CaptureBlock {
+    const void* samples;  // Interleaved integer PCM
+    SampleFormat format;
+    int channels;
+    int frames;
+};
+
+/**
+ * Chain stage that mixes the captured input in (mono sum), converting from
+ * the capture buffer as it goes. Sits after the siren's VCA so the input
+ * is not gated by the envelope. No-op when there is no input.
+ */
+struct ExternalInputStage {
+    const CaptureBlock* input = nullptr;
+    float gain = 1.0f;
+
+    void process(float* buffer, int numSamples) {
+        if (input) {
+            SampleConverter::mixToMono(input->samples, input->format, input->channels, gain,
+                                       buffer, static_cast<size_t>(std::min(numSamples, input->frames)));
+        }
+    }
+};
+
 /**
  * Main Dub Siren Audio Engine.
  * 
  * Integrates all DSP components and provides a thread-safe interface
  * for parameter control from the GPIO controller.
+ *
+ * Parameter setters never touch DSP state directly: they update a
+ * control-side EngineParameters copy, compute derived coefficients and
+ * publish it through a lock-free SnapshotBuffer. process() picks up the
+ * latest snapshot once per block.
  */
 class AudioEngine {
 public:
@@ -43,17 +163,49 @@ public:
      * @param numFrames Number of frames (samples per channel)
      */
     void process(float* output, int numFrames);
+
+    /**
+     * Full-duplex variant: the captured block is mixed into the effect
+     * chain (filter, delay, reverb) alongside the siren.
+     * @param input Captured audio for the same numFrames (may be nullptr)
+     */
+    void process(float* output, int numFrames, const CaptureBlock* input);
     
     /**
      * Trigger the siren sound.
+     * Queued lock-free for the audio thread; the optional timestamp
+     * (monotonicNanos() clock, e.g. the button edge time) positions it
+     * sample-accurately inside the next block.
      */
     void trigger();
+    void trigger(int64_t timestampNs);
     
     /**
      * Release the siren sound.
      */
     void release();
+    void release(int64_t timestampNs);
     
+    /**
+     * Start a one-shot sample over the siren, through the same filter,
+     * delay, reverb and volume. Queued and positioned like trigger().
+     */
+    void triggerSample(int index);
+    void triggerSample(int index, int64_t timestampNs);
+
+    /**
+     * Load one-shot samples from a sample bank file. Call before the
+     * audio output starts.
+     */
+    bool loadSamples(const std::string& path);
+
+    /**
+     * Hold the delay and reverb lines as 32-bit or half-precision floats.
+     * Reallocates and clears them: call before the audio output starts.
+     */
+    void setDelayLineStorage(LineStorage storage);
+    int getSampleCount() const { return sampler.getSampleCount(); }
+
     /**
      * Cycle through pitch envelope modes.
      * @return The new pitch envelope mode name
@@ -93,9 +245,61 @@ public:
     void setReverbMix(float mix);
     void setReverbDamping(float damping);
     
+    // Filter (post-VCA, bypassed by default)
+    void setFilterCutoff(float freq);
+    void setFilterResonance(float res);
+
+    // Effect chain layout
+    void setEffectOrder(EffectOrder order);
+    void setFilterEnabled(bool enabled);
+    void setDelayEnabled(bool enabled);
+    void setReverbEnabled(bool enabled);
+
+    // Full-duplex line input level (0 - 2)
+    void setInputGain(float gain);
+
+    // One-shot sample level (0 - 2)
+    void setSampleGain(float gain);
+
+    // One-shot varispeed in semitones (-24 - +24); the pitch envelope and
+    // LFO pitch modulation apply on top, as they do to the oscillator
+    void setSamplePitch(float semitones);
+
+    // One-shot time-stretch (0.25 - 4, 1 = off), or fit each one-shot to
+    // the delay time; applies to samples started afterwards
+    void setSampleStretch(float factor);
+    void setSampleStretchToDelay(bool enabled);
+
     // Pitch Envelope
     void setPitchEnvelopeMode(PitchEnvelopeMode mode);
 
+    /**
+     * Apply a stored preset as one snapshot. The audio thread crossfades
+     * all continuous parameters (including delay/reverb coefficients) into
+     * it over PRESET_CROSSFADE_SECONDS, so switching does not click.
+     */
+    void applyPreset(const Preset& preset);
+
+    /**
+     * Morph between two presets: frequency, LFO rate/depth, delay time and
+     * feedback, reverb size/mix and release follow setMorphPosition().
+     * Setting the endpoints resets the position to A; the morph takes over
+     * those parameters from the first setMorphPosition() until clearMorph()
+     * or new endpoints, fading in and out like a preset. Setting one of
+     * them meanwhile moves the morph's path so that it plays the new value
+     * at the current position; the path keeps its span towards B.
+     */
+    void setMorphEndpoints(const Preset& a, const Preset& b);
+    void setMorphPosition(float position);  // 0.0 = A, 1.0 = B
+    void clearMorph();
+
+    /**
+     * Group several setter calls into one snapshot publish.
+     * Calls may nest; the snapshot is published when the outermost batch ends.
+     */
+    void beginParameterBatch();
+    void endParameterBatch();
+
     // ========================================================================
     // MP3 Playback Mode
     // ========================================================================
@@ -106,12 +310,26 @@ public:
     // Disable MP3 mode and return to synthesis
     void disableMP3Mode();
 
+    // How MP3 mode buffers decoded audio. Replaces the player, so only
+    // takes effect outside MP3 mode.
+    void setMP3SampleStorage(AudioFilePlayer::SampleStorage storage);
+
+    // Follow each MP3 file that ends with the next one, gapless or
+    // crossfaded over crossfadeSeconds
+    void setMP3Chain(bool chained, float crossfadeSeconds = 0.0f);
+
     // Check if in MP3 mode
     bool isMP3Mode() const { return audioMode.get() == AudioMode::MP3Playback; }
 
     // Start MP3 playback
     void startMP3Playback();
 
+    // Start MP3 playback at a cue point of the current file (0-based)
+    void startMP3Cue(int cue);
+
+    // Get number of cue points of the current MP3 file
+    int getMP3CueCount() const;
+
     // Stop MP3 playback
     void stopMP3Playback();
 
@@ -124,6 +342,9 @@ public:
     // Get number of MP3 files loaded
     int getMP3FileCount() const;
 
+    // More MP3 files are still being loaded in the background
+    bool isMP3Loading() const;
+
     // Get current MP3 filename
     std::string getCurrentMP3FileName() const;
 
@@ -137,10 +358,11 @@ public:
     // Getters
     // ========================================================================
 
-    float getVolume() const { return volume.get(); }
-    float getFrequency() const { return baseFrequency.get(); }
+    float getVolume() const;
+    float getFrequency() const;
+    float getSamplePitch() const;  // Semitones
     bool isPlaying() const { return envelope.isActive() || envelope.getCurrentValue() > 0.001f; }
-    PitchEnvelopeMode getPitchEnvelopeMode() const { return pitchEnvMode.get(); }
+    PitchEnvelopeMode getPitchEnvelopeMode() const;
     
 private:
     int sampleRate;
@@ -150,37 +372,109 @@ private:
     Oscillator oscillator;
     LFO lfo;
     Envelope envelope;
+    LowPassFilter filter;
     DCBlocker dcBlocker;
     DelayEffect delay;
     ReverbEffect reverb;
+    Sampler sampler;
+
+    // Post-oscillator chain, one instantiation per effect order. Both wrap
+    // the same DSP objects, so switching order keeps delay/reverb state.
+    using FilterStage = Bypassable<InPlaceStage<LowPassFilter>>;
+    using DelayStage = Bypassable<InPlaceStage<DelayEffect>>;
+    using ReverbStage = Bypassable<InPlaceStage<ReverbEffect>>;
+    using DCBlockStage = InPlaceStage<DCBlocker>;
+    using DelayFirstChain = EffectChain<EnvelopeGainStage, ExternalInputStage, SamplerStage,
+                                        FilterStage, DelayStage, ReverbStage, DCBlockStage>;
+    using ReverbFirstChain = EffectChain<EnvelopeGainStage, ExternalInputStage, SamplerStage,
+                                         FilterStage, ReverbStage, DelayStage, DCBlockStage>;
+    DelayFirstChain delayFirstChain;
+    ReverbFirstChain reverbFirstChain;
+    const CaptureBlock* captureInput;  // Set for the duration of process()
 
     // MP3 Playback
     std::unique_ptr<AudioFilePlayer> mp3Player;
     
-    // Thread-safe parameters
-    AudioParameter<float> volume;
-    AudioParameter<float> baseFrequency;
-    AudioParameter<float> lfoPitchDepth;  // LFO pitch modulation depth
-    AudioParameter<PitchEnvelopeMode> pitchEnvMode;
+    // Parameter snapshot handoff (control threads -> audio thread)
+    mutable std::mutex controlMutex;   // Serializes control-side writers only
+    EngineParameters controlParams;    // Latest values, owned by control side
+    int batchDepth;                    // Nesting level of parameter batches
+    SnapshotBuffer<EngineParameters> paramSnapshots;
+
+    // Parameters the DSP currently runs with (audio thread only). Equal to
+    // the latest snapshot, except while crossfading into a preset.
+    static constexpr float PRESET_CROSSFADE_SECONDS = 0.05f;
+    EngineParameters activeParams;
+    EngineParameters crossfadeFrom;
+    int crossfadeLength;      // Frames
+    int crossfadeRemaining;   // Frames left, 0 when idle
+    EngineParameters morphTarget;  // Latest snapshot with the morph evaluated
+    SmoothedValue morphPosition;   // Advanced once per block
+
     AudioParameter<AudioMode> audioMode;
     
     // Internal state
     float currentFrequency;
-    SmoothedValue frequencySmooth;
+    SmoothedValue frequencySmooth;  // Base frequency glide (before modulation)
+    SmoothedValue samplePitchSmooth;  // Sample varispeed glide (before modulation)
+    SmoothedValue volumeSmooth;
     
-    // Pitch envelope state
+    // Pitch envelope state (audio thread only)
     bool inReleasePhase;
     float pitchEnvStartLevel;  // Envelope level when release started
+
+    // Note events (control threads -> audio thread)
+    static constexpr int MAX_EVENTS_PER_BLOCK = 16;
+    SpscQueue<NoteEvent, 64> noteEvents;
+    std::mutex eventProducerMutex;  // Serializes producers; never taken by the audio thread
+    std::array<NoteEvent, MAX_EVENTS_PER_BLOCK> blockEvents;
+    std::array<int, MAX_EVENTS_PER_BLOCK> blockEventOffsets;
+    int64_t lastBlockStartNs;       // Start time of the previous block
     
     // Temporary buffers (pre-allocated to avoid allocation in audio thread)
-    std::vector<float> oscBuffer;
+    std::vector<float> oscBuffer;    // Oscillator output, processed in place by the chain
     std::vector<float> envBuffer;
     std::vector<float> lfoBuffer;
-    std::vector<float> processBuffer;
-    std::vector<float> delayBuffer;
-    
-    // Mutex for trigger/release operations
-    std::mutex triggerMutex;
+    std::vector<float> freqBuffer;
+    std::vector<float> volumeBuffer;
+    std::vector<float> pitchModBuffer;    // Oscillator pitch envelope x LFO ratio
+    std::vector<float> samplePitchBuffer; // Sample playback rate
+
+    using MorphLanes = std::array<float, MorphParameters::NUM_LANES>;
+
+    // Update controlParams under controlMutex and publish (unless batching).
+    // A morphed parameter set while the morph is on plays the new value.
+    template<typename Fn>
+    void updateParameters(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        bool morphing = controlParams.morph.enabled;
+        MorphLanes before;
+        if (morphing) {
+            before = readMorphLanes(controlParams);
+        }
+        fn(controlParams);
+        if (morphing && controlParams.morph.enabled) {
+            rebaseMorph(before);
+        }
+        if (batchDepth == 0) {
+            publishParameters();
+        }
+    }
+
+    void publishParameters();  // Caller holds controlMutex
+    static MorphLanes readMorphLanes(const EngineParameters& p);
+    void rebaseMorph(const MorphLanes& before);  // Caller holds controlMutex
+    void loadPreset(const Preset& preset, EngineParameters& p) const;
+    void applyParameters(const EngineParameters& p);  // Audio thread
+    void updateActiveParameters(int numFrames);        // Audio thread
+
+    void pushNoteEvent(NoteEvent::Type type, int64_t timestampNs, int sample = 0);
+    int collectNoteEvents(int numFrames);     // Audio thread
+    void applyNoteEvent(const NoteEvent& event, int offset);  // Audio thread
+    void renderSynth(const EngineParameters& params, int start, int count);
+
+    template<typename Chain>
+    void runEffectChain(Chain& chain, const EngineParameters& params, int numFrames);
 };
 
 } // namespace DubSiren
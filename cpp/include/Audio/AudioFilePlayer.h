@@ -1,32 +1,140 @@
 #pragma once
 
+#include "Audio/SampleBank.h"
+#include "Audio/SampleConverter.h"
 #include <vector>
 #include <string>
+#include <map>
 #include <memory>
 #include <atomic>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * A point to start a file from, in 48kHz output frames. With a loop
+ * (loopEnd past loopStart) playback runs from start to loopEnd and then
+ * repeats loopStart..loopEnd until stopped; without one it runs to the end.
+ */
+struct CuePoint {
+    uint64_t start = 0;
+    uint64_t loopStart = 0;
+    uint64_t loopEnd = 0;
+
+    bool loops() const { return loopEnd > loopStart; }
+};
+
+struct MP3FrameIndex;  // Seek table, defined with the decoder
 
 struct AudioFile {
-    std::vector<float> samples;  // Interleaved stereo samples
+    std::string path;
     std::string filename;
-    int sampleRate;
+    int sampleRate;  // Source rate; converted to 48kHz stereo while decoding
     int channels;
+    int bankEntry;   // Index in the sample bank, or -1 for an MP3 file
+    std::vector<CuePoint> cues;                       // At most AudioFilePlayer::MAX_CUES
+    std::shared_ptr<const MP3FrameIndex> frameIndex;  // MP3 files with cues only
 
-    AudioFile() : sampleRate(48000), channels(2) {}
+    AudioFile() : sampleRate(48000), channels(2), bankEntry(-1) {}
 };
 
+/**
+ * The playable files, built by loadFilesFromDirectory() and never changed
+ * once published. The decoder holds a reference to the library it streams
+ * from, so a bank stays mapped until nothing plays from it.
+ */
+struct SampleLibrary : std::enable_shared_from_this<SampleLibrary> {
+    std::vector<AudioFile> files;
+    DubSiren::SampleBank bank;  // Mapped when the files come from a bank
+};
+
+/**
+ * Plays MP3 files by streaming them through a background decoder thread.
+ *
+ * Nothing is decoded up front: loading only checks each file's header, on
+ * up to MAX_LOAD_WORKERS threads and in the background after the first, or
+ * maps a prebuilt sample bank (BANK_FILE in the directory) whose PCM the
+ * decoder then copies instead of decoding. For the selected file the
+ * decoder keeps the first PREROLL_FRAMES decoded in a preroll buffer, so
+ * play() starts instantly, and keeps a lock-free ring of RING_FRAMES
+ * (~340 ms) filled with what follows. Memory use is the same however many
+ * files there are and however long they run.
+ *
+ * Loading builds a new SampleLibrary while the old one stays in use and
+ * swaps it in with a single pointer store. Readers never lock: they count
+ * themselves in and out around their read, and the loader waits for that
+ * count to drain before dropping its reference to the old library, which
+ * is then released by whichever non-audio thread held it last.
+ *
+ * The audio thread never locks or waits: it plays the preroll, then the
+ * ring. A retrigger after the ring has been read asks the decoder to restart
+ * the stream behind the preroll, which leaves it a whole preroll to do so.
+ * If the ring runs dry anyway the gap is played as silence and counted.
+ *
+ * Cue points (CUES_FILE in the directory) start a file part way in just
+ * as fast: for the selected file the decoder also keeps CUE_PREROLL_FRAMES
+ * (~85 ms) from every cue and loop start, and playCue() plays from one while
+ * the decoder restarts the ring behind it, so jumping to a cue costs the
+ * audio thread the same whatever the cue. MP3 files with cues get a frame
+ * index (byte offset of every frame) when they are loaded, so the restart
+ * seeks straight to the frame instead of decoding from the top; a sample
+ * bank is seeked by frame number. A loop is played as two segments, start
+ * to loop end and loop start to loop end, the stream ending at the loop end
+ * and the loop start's preroll following it in the same block; a loop
+ * shorter than the preroll never involves the decoder.
+ *
+ * In chain mode (setChained()) a file that plays to its end is followed by
+ * the next one without a gap. While a file plays, the decoder prefetches
+ * the next file into the free slot with a second stream: its cue prerolls,
+ * its preroll, and the decoder positioned right after it. When the current
+ * stream ends it carries on from the prefetched one, whose frames follow
+ * in the ring at once, and offers it to the audio thread. The audio thread
+ * switches to the next file's preroll on the frame after the last one,
+ * optionally crossfading the two files over the tail. Retriggering or
+ * selecting another file before then declines the offer. Only a file
+ * shorter than the decoder takes to prefetch the one after it (tens of ms)
+ * can leave a gap.
+ *
+ * The preroll and ring hold float samples, or with SampleStorage::Int16
+ * dithered 16-bit PCM that fillBuffer() converts back a block at a time:
+ * half the locked memory and half the bytes read per block.
+ */
 class AudioFilePlayer {
 public:
-    AudioFilePlayer();
+    // How decoded audio is held between the decoder and the audio thread
+    enum class SampleStorage {
+        Float,  // 32-bit float
+        Int16   // 16-bit PCM, TPDF dithered
+    };
+
+    explicit AudioFilePlayer(SampleStorage storage = SampleStorage::Float);
     ~AudioFilePlayer();
 
-    // Load all MP3 files from a directory
+    SampleStorage getSampleStorage() const { return storage; }
+
+    // Map the directory's sample bank, or find its MP3 files, and start the
+    // decoder. MP3 files are checked in the background: this returns once
+    // the first is ready to play. On failure the current files are kept.
     bool loadFilesFromDirectory(const std::string& directory);
 
-    // Get number of loaded files
-    int getFileCount() const { return static_cast<int>(audioFiles.size()); }
+    // True while the last load is still checking files; getFileCount()
+    // counts the files ready so far
+    bool isLoading() const { return loading.load(); }
+
+    // Bank file name looked for by loadFilesFromDirectory()
+    static constexpr const char* BANK_FILE = "samples.bank";
+
+    // Cue list looked for by loadFilesFromDirectory(): one cue per line,
+    // "FILENAME START [LOOP_START LOOP_END]" in seconds, '#' comments
+    static constexpr const char* CUES_FILE = "cues.txt";
+    static constexpr int MAX_CUES = 8;  // Per file
+
+    // Get number of loaded files (ready to play)
+    int getFileCount() const;
 
-    // Select which file to play (0-based index)
+    // Select which file to play (0-based index). Output is silent until
+    // the decoder has its preroll ready; a play() meanwhile starts the new file
     void selectFile(int index);
 
     // Get current file index
@@ -38,6 +146,13 @@ public:
     // Start playback from beginning
     void play();
 
+    // Start playback at one of the current file's cue points (0-based);
+    // a cue the file does not have plays from the beginning
+    void playCue(int cue);
+
+    // Number of cue points of the current file
+    int getCueCount() const;
+
     // Stop playback
     void stop();
 
@@ -53,26 +168,251 @@ public:
     // Fill audio buffer with samples (called from audio thread)
     void fillBuffer(float* output, int numFrames);
 
+    // Chain mode: follow a file that ends with the next one, crossfading
+    // over crossfadeSeconds (0: straight cut, at most 100 ms); the last file
+    // still ends playback
+    void setChained(bool chained, float crossfadeSeconds = 0.0f);
+    bool isChained() const { return chainFiles.load(); }
+    float getChainCrossfade() const;
+
+    // Blocks played as silence because the decoder fell behind
+    uint64_t getUnderruns() const { return underruns.load(); }
+
     // Get LED color for current file
     struct Color {
         uint8_t r, g, b;
     };
     Color getColorForCurrentFile() const;
 
+    // Palette color for the index-th file
+    static Color defaultColor(int index);
+
 private:
-    std::vector<AudioFile> audioFiles;
+    static constexpr int OUTPUT_RATE = 48000;
+    static constexpr size_t PREROLL_FRAMES = 24000;     // 0.5 s from the top
+    static constexpr size_t CUE_PREROLL_FRAMES = 4096;  // ~85 ms from each cue and loop start
+    static constexpr int MAX_CUE_ENTRIES = 2 * MAX_CUES;
+    static constexpr size_t RING_FRAMES = 16384;        // ~340 ms at 48kHz (power of two)
+    static constexpr size_t MAX_CHAIN_FADE = 4800;      // 100 ms, well within what the ring holds
+    static constexpr int DECODER_POLL_MS = 10;
+    static constexpr unsigned MAX_LOAD_WORKERS = 3;    // Leaves a core to the audio thread
+
+    struct DecodeStream;  // Decoder thread state (minimp3)
+    class LibraryReader;  // Read-side section on the published library
+    struct LoadJob;       // Files being checked by the loader
+
+    // Interleaved stereo frames in the configured storage
+    class FrameStore {
+    public:
+        void allocate(size_t frames, SampleStorage storage);
+        bool isAllocated() const { return floats || pcm; }
+
+        // Decoder thread. Int16 storage dithers with converter, or just
+        // rounds input that came from 16-bit PCM (quantized)
+        void write(size_t frame, const float* input, size_t frames,
+                   DubSiren::SampleConverter& converter, bool quantized);
+
+        // Audio thread
+        void read(size_t frame, float* output, size_t frames) const;
+
+    private:
+        std::unique_ptr<float[]> floats;
+        std::unique_ptr<int16_t[]> pcm;
+    };
+
+    struct Preroll {
+        FrameStore samples;  // PREROLL_FRAMES, or CUE_PREROLL_FRAMES for a cue
+        size_t frames = 0;
+    };
+
+    // The selected file's cues, decoded into the same slot as its preroll.
+    // Playback targets are numbered TOP for the start of the file, 2 * cue
+    // for a cue and 2 * cue + 1 for its loop.
+    struct CueSet {
+        struct Cue {
+            int entry;            // Preroll from the start
+            int loopEntry;        // Preroll from the loop start, -1 without a loop
+            uint64_t length;      // Start to loop end; 0 plays to the end
+            uint64_t loopLength;  // Loop start to loop end
+        };
+
+        Preroll entries[MAX_CUE_ENTRIES];  // Allocated with the first cues; shared by
+                                           // cues starting at the same frame
+        Cue cues[MAX_CUES];
+        int count = 0;
+    };
+
+    static constexpr int TOP = -1;
+
+    using CueMap = std::map<std::string, std::vector<CuePoint>>;
+
+    const SampleStorage storage;
+
+    // Published library: read inside a LibraryReader, owned by libraryOwner
+    std::atomic<const SampleLibrary*> library{nullptr};
+    mutable std::atomic<int> libraryReaders{0};
+    std::shared_ptr<const SampleLibrary> libraryOwner;
+    std::mutex loadMutex;  // Serializes loaders only
+
+    // Background load (publishes the library as files are checked)
+    std::unique_ptr<LoadJob> loadJob;
+    std::thread loaderThread;
+    std::atomic<bool> loading{false};
+
     std::atomic<int> currentFileIndex{0};
-    std::atomic<size_t> playbackPosition{0};
     std::atomic<bool> playing{false};
     std::atomic<bool> finished{false};
 
-    mutable std::mutex filesMutex;
+    // Two preroll slots: the decoder fills the one the audio thread is not using
+    Preroll prerolls[2];
+    CueSet cueSets[2];
+
+    // Decoded stereo frames following the preroll (positions count frames)
+    FrameStore ring;
+    alignas(64) std::atomic<size_t> ringWrite{0};
+    alignas(64) std::atomic<size_t> ringRead{0};
+
+    // Control -> decoder
+    std::atomic<uint32_t> selectRequests{0};
+
+    // Control -> audio thread: the cue is stored before the request is counted
+    std::atomic<uint32_t> playRequests{0};
+    std::atomic<int> requestedCue{TOP};
+
+    // Audio thread -> decoder: restart the ring behind a target's preroll
+    std::atomic<uint32_t> rewindRequests{0};
+    std::atomic<int> rewindTarget{TOP};
+    std::atomic<uint32_t> ackedSerial{0};
+
+    // Control -> audio thread and decoder
+    std::atomic<bool> chainFiles{false};
+    std::atomic<size_t> chainFadeFrames{0};
+
+    // Audio thread -> decoder: the chained stream last acknowledged was taken
+    // up (rather than declined)
+    std::atomic<uint32_t> chainTaken{0};
+
+    // Decoder -> audio thread: a new stream starts at streamStart in the ring,
+    // answering the rewinds and selects counted up to streamRewinds and
+    // streamSelects. A chained stream starts where the previous one ends and
+    // waits for it to be played out.
+    std::atomic<uint32_t> streamSerial{0};
+    std::atomic<size_t> streamStart{0};
+    std::atomic<int> streamSlot{0};
+    std::atomic<int> streamFile{0};
+    std::atomic<uint32_t> streamRewinds{0};
+    std::atomic<uint32_t> streamSelects{0};
+    std::atomic<bool> streamChained{false};
+    std::atomic<uint32_t> eofSerial{0};
+    std::atomic<size_t> eofPos{0};
+
+    std::atomic<uint64_t> underruns{0};
+
+    // Audio thread only
+    uint32_t activeSerial = 0;    // Last stream acknowledged
+    uint32_t activeSelects = 0;   // Selects it answered
+    uint32_t ringSerial = 0;      // Stream being read from the ring
+    int activeSlot = 0;
+    int activeFile = 0;
+    int activeTarget = TOP;       // Segment playing
+    int ringTarget = TOP;         // Segment the ring holds, or is awaited for
+    uint32_t handledPlays = 0;
+    uint32_t sentRewinds = 0;
+    size_t prerollPos = 0;
+    bool ringConsumed = false;
+    bool awaitingStream = true;  // Until the first stream is published
+    bool chainOffered = false;   // A chained stream waits for the end of the file
+    uint32_t offeredSerial = 0;
+    size_t chainEnd = 0;         // Ring position where the offered stream starts
+    size_t chainFade = 0;        // Frames crossfaded before chainEnd
+
+    // Decoder thread
+    std::unique_ptr<DecodeStream> stream;
+    std::unique_ptr<DecodeStream> nextStream;  // Chain mode: the next file, past its preroll
+    int nextFile = -1;                          // File prefetched in nextStream, or -1
+    bool chainPending = false;                  // Chained stream published, not yet acknowledged
+    uint32_t publishedSerial = 0;
+    uint32_t handledSelects = 0;
+    uint32_t handledRewinds = 0;
+    uint64_t reportedUnderruns = 0;
+    std::thread decoderThread;
+    std::atomic<bool> decoderRunning{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeDecoder;
+
+    void startDecoder();
+    void stopDecoder();
+    void decoderLoop();
+
+    // Open a file at a frame on s and decode prerollFrames of it (into target,
+    // or discarded if null); the stream then ends length frames from start
+    // (0: at the end of the file)
+    bool openStream(DecodeStream& s, const AudioFile& file, uint64_t start, size_t prerollFrames,
+                    uint64_t length, Preroll* target);
+    void publishStream(int slot, bool chained = false);
+
+    // Decode the preroll of every cue and loop start of a file into cueSet
+    void prepareCues(DecodeStream& s, const AudioFile& file, CueSet& cueSet);
+
+    // Chain mode: the file to follow the current stream's end, or -1
+    int chainTarget() const;
+
+    // Open a file on nextStream, its prerolls going into the free slot
+    void prefetchFile(int index);
+
+    // Carry on from nextStream where the current stream ends
+    void publishChain();
+
+    // The chained stream was acknowledged: go back to the ended file if the
+    // audio thread declined it
+    void settleChain();
+
+    // Restart the ring behind a target's preroll in the current slot
+    void restartStream(const AudioFile& file, int target);
+
+    // Audio thread: the preroll and length (0: to the end) of a target
+    const Preroll& prerollFor(int target) const;
+    uint64_t segmentLength(int target) const;
+
+    // Audio thread: play a target from its preroll, asking for its stream
+    // when the segment runs past the preroll
+    void startSegment(int target);
+    void requestStream(int target);
+
+    // Audio thread: the offered chain follows what is playing (the ring's
+    // stream, to its end) and no other file was selected since
+    bool chainFollows() const;
+    void offerChain(uint32_t serial);
+    void takeChain();
+    void declineChain();
+
+    // Audio thread: where the ring's stream ends, if known yet
+    bool ringEnd(size_t& end) const;
+
+    // Audio thread: crossfade ring frames from pos into the offered file's preroll
+    void crossfadeChain(float* block, size_t pos, size_t frames) const;
+
+    // Decode into the ring while there is room; false if nothing was done
+    bool fillRing();
+
+    // Check a file decodes and read its format
+    static bool probeMP3File(DecodeStream& probe, const std::string& filepath, AudioFile& audioFile);
+
+    // Map a bank file and list its samples
+    static bool loadBank(const std::string& path, const CueMap& cues, SampleLibrary& target);
+
+    // Read a cue list; a missing file means no cues
+    static CueMap readCues(const std::string& path);
+
+    // Swap in a new library and release the old one once no reader holds it
+    void publishLibrary(std::shared_ptr<const SampleLibrary> next);
 
-    // Load a single MP3 file
-    bool loadMP3File(const std::string& filepath, AudioFile& audioFile);
+    // Publish a library as a fresh start: file 0 selected, playback stopped
+    void installLibrary(std::shared_ptr<const SampleLibrary> next);
 
-    // Resample audio if needed (convert to 48kHz stereo)
-    void resampleAudio(AudioFile& audioFile, int sourceSampleRate, int sourceChannels);
+    // Check MP3 files on a worker pool and merge them in order
+    void loaderLoop(LoadJob& job);
+    void cancelLoad();
 
     // Predefined colors for different files
     static const Color FILE_COLORS[];
@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "Audio/AudioEngine.h"
+#include "Audio/SampleConverter.h"
 #include <thread>
 #include <atomic>
 #include <memory>
@@ -14,6 +15,9 @@ typedef struct _snd_pcm snd_pcm_t;
 
 namespace DubSiren {
 
+class LatencyController;
+class AudioRecorder;
+
 /**
  * ALSA audio output handler.
  * Manages real-time audio streaming to the PCM5102 I2S DAC.
@@ -43,6 +47,50 @@ public:
      */
     void stop();
     
+    /**
+     * Use SND_PCM_ACCESS_MMAP_INTERLEAVED when the device supports it
+     * (default). Samples are then converted straight into the DMA ring
+     * instead of a staging buffer plus snd_pcm_writei. Call before start().
+     */
+    void setMmapEnabled(bool enabled) { useMmap = enabled; }
+
+    /**
+     * Force a sample format. By default S32_LE, S24_LE and S16_LE are
+     * tried in that order. Call before start().
+     */
+    void setSampleFormat(SampleFormat format) { forcedFormat = format; formatForced = true; }
+
+    /**
+     * Start at the lowest latency (64x2) and let a LatencyController move
+     * the period size/count up on underruns or high load, and back down
+     * once stable. bufferSize caps the period size. Call before start().
+     */
+    void setAdaptiveLatency(bool enabled) { adaptiveLatency = enabled; }
+
+    /**
+     * Number of bufferSize periods in the ALSA ring (default 3). Two halves
+     * the output latency but leaves one period of slack. Call before start().
+     */
+    void setPeriodCount(int count) { periodCount = std::max(2, count); }
+
+    /**
+     * Feed every rendered block to a recorder (may be nullptr).
+     * Call before start().
+     */
+    void setRecorder(AudioRecorder* rec) { recorder = rec; }
+
+    /**
+     * Full-duplex FX mode: capture from captureDevice (nullptr: the playback
+     * device), linked to playback for a shared clock, and run the line
+     * input through filter/delay/reverb with the siren. Adds one period of
+     * latency (the capture period). Disables adaptive latency. Call before
+     * start().
+     */
+    void setDuplex(bool enabled, const char* captureDevice = nullptr) {
+        duplex = enabled;
+        captureDeviceName = captureDevice ? captureDevice : "";
+    }
+
     /**
      * Check if audio is running.
      */
@@ -54,7 +102,9 @@ public:
     struct Stats {
         uint64_t totalBuffers;
         uint64_t underruns;
+        uint64_t captureOverruns;  // Full-duplex mode only
         float cpuUsage;  // Estimated CPU usage percentage
+        float headroomMs;  // Audio still queued when woken up (mmap mode)
     };
     Stats getStats() const;
     
@@ -64,6 +114,23 @@ private:
     int bufferSize;
     int channels;
     std::string deviceName;
+    bool useMmap;
+    bool formatForced;
+    SampleFormat forcedFormat;
+    bool adaptiveLatency;
+    int periodCount;
+    AudioRecorder* recorder;
+    bool duplex;
+    std::string captureDeviceName;
+
+    // Negotiated by configureAlsa (audio thread)
+    SampleConverter converter;
+    bool mmapActive;
+    int periodFrames;
+    int ringFrames;
+    SampleFormat captureFormat;
+    bool captureMmap;
+    unsigned long captureOffset;  // mmap: offset of the pending capture block
     
     std::atomic<bool> running;
     std::thread audioThread;
@@ -71,33 +138,81 @@ private:
     // Statistics
     std::atomic<uint64_t> totalBuffers;
     std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> captureOverruns;
     std::atomic<float> lastCpuUsage;
+    std::atomic<float> lastHeadroomMs;
     
     void audioLoop();
     void setRealtimePriority();
 #ifdef HAVE_ALSA
-    bool configureAlsa(snd_pcm_t* pcm);
+    bool configureAlsa(snd_pcm_t* pcm, int requestedPeriod, int requestedPeriods);
+    snd_pcm_t* openPcm(int requestedPeriod, int requestedPeriods);
+    snd_pcm_t* reopenPcm(snd_pcm_t* pcm, const LatencyController& latency, const char* reason);
+    long waitForSpace(snd_pcm_t* pcm);                  // mmap: frames available, or -errno
+    long renderMmap(snd_pcm_t* pcm, float* floatBuffer, const CaptureBlock* input);  // mmap: frames committed, or -errno
+
+    // Full duplex
+    snd_pcm_t* openCapture(snd_pcm_t* playback);
+    bool configureCapture(snd_pcm_t* capture);
+    bool startDuplex(snd_pcm_t* pcm, snd_pcm_t* capture, std::vector<int32_t>& silence);
+    long beginCapture(snd_pcm_t* capture, int frames, CaptureBlock& block, int32_t* readBuffer);
+    long endCapture(snd_pcm_t* capture, const CaptureBlock& block);
 #endif
 };
 
 /**
  * Simulated audio output for testing without hardware.
+ *
+ * Behaves like a sound card clock: blocks are paced on absolute deadlines
+ * (start + n * block duration), so processing time does not make the clock
+ * drift. A block that finishes after its deadline counts as a virtual
+ * underrun. Wake-up lateness and processing time are collected in
+ * histograms and reported on stop, which makes it usable for checking RT
+ * behaviour on machines without a sound card.
  */
 class SimulatedAudioOutput {
 public:
-    SimulatedAudioOutput(AudioEngine& engine, int bufferSize = DEFAULT_BUFFER_SIZE);
+    SimulatedAudioOutput(AudioEngine& engine,
+                         int sampleRate = DEFAULT_SAMPLE_RATE,
+                         int bufferSize = DEFAULT_BUFFER_SIZE);
     ~SimulatedAudioOutput();
     
     bool start();
     void stop();
     bool isRunning() const { return running.load(); }
+
+    /**
+     * Run the simulated device thread at SCHED_FIFO like the real output.
+     * Call before start().
+     */
+    void setRealtimeEnabled(bool enabled) { realtime = enabled; }
+
+    /**
+     * Feed every rendered block to a recorder (may be nullptr).
+     * Call before start().
+     */
+    void setRecorder(AudioRecorder* rec) { recorder = rec; }
+
+    struct Stats {
+        uint64_t totalBuffers;
+        uint64_t virtualUnderruns;  // Blocks finished after their deadline
+        float maxWakeLatencyUs;     // Worst wake-up lateness seen so far
+    };
+    Stats getStats() const;
     
 private:
     AudioEngine& engine;
+    int sampleRate;
     int bufferSize;
+    bool realtime;
+    AudioRecorder* recorder;
     std::atomic<bool> running;
     std::thread simulationThread;
     std::vector<float> buffer;
+
+    std::atomic<uint64_t> totalBuffers;
+    std::atomic<uint64_t> virtualUnderruns;
+    std::atomic<float> maxWakeLatencyUs;
     
     void simulationLoop();
 };
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Common.h"
+#include <thread>
+#include <atomic>
+#include <string>
+#include <memory>
+
+namespace DubSiren {
+
+/**
+ * Records the output to a 32-bit float WAV file.
+ *
+ * The audio thread copies each finished block into a preallocated
+ * single-producer/single-consumer sample ring (pushBlock: no locks, no
+ * allocation, no syscalls). A normal-priority writer thread drains the ring
+ * into a page-aligned buffer and writes it out in WRITE_CHUNK_BYTES pieces;
+ * the header is laid out so audio data starts on a 4 KiB boundary.
+ *
+ * If storage stalls long enough for the ring to fill (RING_SECONDS of
+ * audio), whole blocks are dropped and counted rather than blocking the
+ * audio thread. Files that grow past 4 GiB are finalized as RF64. The
+ * header sizes are refreshed every few seconds so a power cut leaves a
+ * playable file.
+ */
+class AudioRecorder {
+public:
+    AudioRecorder(int sampleRate, int channels = DEFAULT_CHANNELS);
+    ~AudioRecorder();
+
+    // Non-copyable
+    AudioRecorder(const AudioRecorder&) = delete;
+    AudioRecorder& operator=(const AudioRecorder&) = delete;
+
+    /**
+     * Open the file and start the writer thread. If path is a directory a
+     * timestamped dubsiren-YYYYMMDD-HHMMSS.wav is created inside it.
+     * @return true if recording started
+     */
+    bool start(const std::string& path);
+
+    /**
+     * Flush what is queued, finalize the header and close the file.
+     */
+    void stop();
+
+    bool isRecording() const { return recording.load(std::memory_order_acquire); }
+
+    /**
+     * Queue one interleaved block. Audio thread only; real-time safe.
+     */
+    void pushBlock(const float* interleaved, int numFrames);
+
+    struct Stats {
+        uint64_t framesWritten;
+        uint64_t droppedBlocks;
+        uint64_t droppedFrames;
+    };
+    Stats getStats() const;
+
+private:
+    static constexpr float RING_SECONDS = 4.0f;
+    static constexpr size_t WRITE_CHUNK_BYTES = 256 * 1024;
+    static constexpr size_t DATA_OFFSET = 4096;
+    static constexpr float HEADER_UPDATE_SECONDS = 5.0f;
+
+    int sampleRate;
+    int channels;
+    std::string filePath;
+    int fd;
+
+    // Sample ring (power-of-two size, positions count samples)
+    std::unique_ptr<float[]> ring;
+    size_t ringMask;
+    alignas(64) std::atomic<size_t> writePos;
+    alignas(64) std::atomic<size_t> readPos;
+
+    // Writer-thread staging buffer (page aligned)
+    float* chunk;
+    size_t chunkSamples;
+
+    std::atomic<bool> recording;
+    std::atomic<bool> writerRunning;
+    std::thread writerThread;
+
+    std::atomic<uint64_t> framesWritten;
+    std::atomic<uint64_t> droppedBlocks;
+    std::atomic<uint64_t> droppedFrames;
+    uint64_t dataBytes;  // Writer thread
+
+    void writerLoop();
+    size_t drainRing(size_t filled);  // Appends ring -> chunk, returns samples moved
+    bool writeChunk(size_t samples);
+    bool writeHeader();
+};
+
+} // namespace DubSiren
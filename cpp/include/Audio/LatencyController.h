@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Common.h"
+
+namespace DubSiren {
+
+/**
+ * Picks the lowest stable ALSA period configuration for this box.
+ *
+ * Starts on the most aggressive rung of a ladder of (period size, period
+ * count) settings. Every rendered period reports its processing load
+ * (time spent / period duration) and whether it underran:
+ * - an underrun, or a p99.9 load above STEP_UP_LOAD over one window,
+ *   steps one rung up (more latency) right away;
+ * - after a hold time on a rung with no underruns and every window's
+ *   p99.9 load below STEP_DOWN_LOAD it tries one rung down; a window at
+ *   or above it starts the hold again. Each failure of a rung doubles
+ *   the hold time before it is tried again, so a box with periodic
+ *   background load settles instead of oscillating.
+ *
+ * Pure bookkeeping, called from the audio thread: no allocation, no locks.
+ */
+class LatencyController {
+public:
+    struct Setting {
+        int periodFrames;
+        int periods;
+    };
+
+    /**
+     * @param maxPeriodFrames Largest period the engine can render in one call
+     */
+    LatencyController(int sampleRate, int maxPeriodFrames);
+
+    Setting current() const { return LADDER[rung]; }
+
+    /**
+     * Record one period.
+     * @param frames Frames rendered
+     * @param load Processing time / period duration (1.0 = no headroom)
+     * @return true if current() changed and the PCM must be reconfigured
+     */
+    bool recordPeriod(int frames, float load, bool underrun);
+
+    // p99.9 load of the last completed window
+    float getLoadP999() const { return lastWindowP999; }
+
+private:
+    static constexpr Setting LADDER[] = {
+        {64, 2}, {64, 3}, {128, 2}, {128, 3}, {256, 2}, {256, 3}, {512, 2}, {512, 3}, {1024, 3}
+    };
+    static constexpr int NUM_RUNGS = sizeof(LADDER) / sizeof(LADDER[0]);
+
+    static constexpr int HISTOGRAM_BINS = 100;      // Load 0.0 - 2.0 in 0.02 steps
+    static constexpr float WINDOW_SECONDS = 2.0f;
+    static constexpr float BASE_HOLD_SECONDS = 30.0f;
+    static constexpr float STEP_UP_LOAD = 0.8f;
+    static constexpr float STEP_DOWN_LOAD = 0.5f;
+
+    int sampleRate;
+    int topRung;           // Highest rung that fits maxPeriodFrames
+    int rung;
+    int holdFailures[NUM_RUNGS];  // Failures per rung (doubles its hold time)
+
+    uint32_t histogram[HISTOGRAM_BINS];
+    uint32_t windowPeriods;
+    int64_t windowFrames;
+    int64_t stableFrames;  // Frames since the last window at or above STEP_DOWN_LOAD
+    float lastWindowP999;
+
+    bool moveTo(int newRung);
+    float windowP999() const;
+    void resetWindow();
+};
+
+} // namespace DubSiren
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+#include <type_traits>
+
+namespace DubSiren {
+
+/**
+ * Preset groups (one per secret mode with presets).
+ */
+enum class PresetGroup : uint8_t {
+    NJD = 0,
+    UFO = 1
+};
+
+/**
+ * Fixed-size preset record, stored verbatim in the binary bank file.
+ *
+ * Plain little-endian floats and bytes: a record is used in place straight
+ * from the mapped file, there is nothing to parse.
+ */
+struct Preset {
+    // flags
+    static constexpr uint8_t HAS_LFO_RATE = 0x01;         // Sets LFO rate and waveform
+    static constexpr uint8_t HAS_LFO_DEPTH = 0x02;        // Sets LFO (filter) depth
+    static constexpr uint8_t HAS_LFO_PITCH_DEPTH = 0x04;  // Sets LFO pitch depth
+
+    char name[24];          // NUL-terminated
+    uint8_t group;          // PresetGroup
+    uint8_t flags;
+    uint8_t oscWaveform;    // Waveform index
+    uint8_t lfoWaveform;    // Waveform index
+    float baseFrequency;    // Hz
+    float releaseTime;      // Seconds
+    float delayTime;        // Seconds
+    float delayFeedback;
+    float reverbSize;
+    float reverbMix;
+    float lfoRate;          // Hz
+    float lfoDepth;
+    float lfoPitchDepth;    // Octaves
+};
+
+static_assert(sizeof(Preset) == 64, "Preset record layout is part of the file format");
+static_assert(std::is_trivially_copyable<Preset>::value, "Preset must be usable in place");
+
+/**
+ * Binary preset bank.
+ *
+ * File layout: a 16-byte header followed by an array of Preset records.
+ *     char     magic[4]    "DSPB"
+ *     uint16_t version     2 (version 1 set both LFO depths with HAS_LFO_DEPTH)
+ *     uint16_t count       number of records
+ *     uint32_t recordSize  sizeof(Preset)
+ *     uint32_t reserved
+ *
+ * A file bank is mmap'ed read-only and used in place. Without a file the
+ * bank built into the binary is used. Load before the controller starts;
+ * lookups are read-only and never allocate.
+ */
+class PresetBank {
+public:
+    PresetBank();
+    ~PresetBank();
+
+    PresetBank(const PresetBank&) = delete;
+    PresetBank& operator=(const PresetBank&) = delete;
+
+    /**
+     * Map a bank file. On failure the current bank stays in use.
+     */
+    bool loadFromFile(const std::string& path);
+
+    /**
+     * Write the current bank to a file (e.g. to start a custom bank
+     * from the built-in one).
+     */
+    bool saveToFile(const std::string& path) const;
+
+    // Number of presets in a group
+    int count(PresetGroup group) const;
+
+    // index-th preset of a group, or nullptr
+    const Preset* find(PresetGroup group, int index) const;
+
+    // Normal-mode sound restored when leaving NJD/UFO mode (built in,
+    // not part of any bank file)
+    static const Preset& normalMode();
+
+private:
+    const Preset* presets;
+    int numPresets;
+    void* mapping;       // Non-null when presets point into a file mapping
+    size_t mappingSize;
+
+    void unmap();
+};
+
+} // namespace DubSiren
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace DubSiren {
+
+/**
+ * Directory record for one sample, stored verbatim in the bank file.
+ */
+struct SampleBankEntry {
+    char name[40];          // NUL-terminated (source file name)
+    uint64_t offset;        // Start of the PCM data, DATA_ALIGNMENT aligned
+    uint64_t frames;        // Stereo frames at SAMPLE_RATE
+    uint8_t color[3];       // LED color (r, g, b)
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(SampleBankEntry) == 64, "Sample entry layout is part of the file format");
+static_assert(std::is_trivially_copyable<SampleBankEntry>::value, "SampleBankEntry must be usable in place");
+
+/**
+ * Prebuilt sample bank: MP3/WAV files decoded and resampled ahead of time
+ * (see the dubsiren-pack tool) so the player starts without decoding.
+ *
+ * File layout: a 16-byte header, the entry table, then each sample's
+ * interleaved 48kHz stereo PCM starting on a 4 KiB boundary.
+ *     char     magic[4]    "DSSB"
+ *     uint16_t version     1
+ *     uint16_t count       number of entries
+ *     uint32_t sampleRate  48000
+ *     uint16_t format      FORMAT_S16 or FORMAT_FLOAT (WAVE format tags)
+ *     uint16_t channels    2
+ *
+ * The file is mmap'ed read-only without being page-locked, even under
+ * mlockall(MCL_FUTURE): pages are read in as they are played and stay
+ * reclaimable, so RAM use does not grow with the size of the bank.
+ */
+class SampleBank {
+public:
+    static constexpr uint16_t FORMAT_S16 = 1;
+    static constexpr uint16_t FORMAT_FLOAT = 3;
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 2;
+    static constexpr size_t DATA_ALIGNMENT = 4096;
+
+    // One sample to pack
+    struct Source {
+        std::string name;
+        uint8_t color[3];
+        std::vector<float> samples;  // Interleaved stereo at SAMPLE_RATE
+    };
+
+    SampleBank();
+    ~SampleBank();
+
+    SampleBank(const SampleBank&) = delete;
+    SampleBank& operator=(const SampleBank&) = delete;
+
+    /**
+     * Map a bank file. On failure the bank is left empty.
+     */
+    bool load(const std::string& path);
+
+    /**
+     * Write a bank file (float samples converted to format).
+     */
+    static bool write(const std::string& path, const std::vector<Source>& sources, uint16_t format);
+
+    bool isLoaded() const { return mapping != nullptr; }
+
+    int count() const { return numEntries; }
+    uint16_t getFormat() const { return format; }
+    size_t bytesPerFrame() const { return CHANNELS * (format == FORMAT_S16 ? sizeof(int16_t) : sizeof(float)); }
+
+    // index-th entry, or nullptr
+    const SampleBankEntry* entry(int index) const;
+
+    // Start of an entry's PCM data in the mapping
+    const void* data(const SampleBankEntry& entry) const;
+
+private:
+    const SampleBankEntry* entries;
+    int numEntries;
+    uint16_t format;
+    void* mapping;
+    size_t mappingSize;
+
+    void unmap();
+};
+
+} // namespace DubSiren
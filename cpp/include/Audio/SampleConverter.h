@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+
+namespace DubSiren {
+
+/**
+ * PCM sample formats supported by the output.
+ */
+enum class SampleFormat {
+    S16,  // 16-bit (S16_LE), TPDF dithered
+    S24,  // 24-bit in the low bits of a 32-bit word (S24_LE)
+    S32   // 32-bit (S32_LE), 24 significant bits from float
+};
+
+/**
+ * Float to interleaved integer PCM conversion.
+ *
+ * The loops are branch-free (clamp via min/max) so they auto-vectorize.
+ * On the 16-bit path a triangular (TPDF) dither of +/-1 LSB is added before
+ * rounding, so quiet reverb tails decay into noise instead of truncation
+ * distortion. The dither comes from four interleaved xorshift generators,
+ * which keeps the random numbers independent of each other per lane.
+ */
+class SampleConverter {
+public:
+    explicit SampleConverter(SampleFormat format = SampleFormat::S16);
+
+    void setFormat(SampleFormat newFormat) { format = newFormat; }
+    SampleFormat getFormat() const { return format; }
+
+    // Container size of one sample in bytes
+    int bytesPerSample() const { return (format == SampleFormat::S16) ? 2 : 4; }
+
+    /**
+     * Convert samples (any channel layout) into the current format.
+     * @param output Destination with room for count * bytesPerSample() bytes
+     */
+    void convert(const float* input, void* output, size_t count);
+
+    static const char* formatName(SampleFormat format);
+
+    /**
+     * Add interleaved integer PCM (e.g. a capture period, read in place)
+     * to a mono float buffer: the channel average times gain.
+     */
+    static void mixToMono(const void* input, SampleFormat format, int channels,
+                          float gain, float* output, size_t frames);
+
+    /**
+     * 16-bit PCM back to float in [-1, 1), eight samples per step on NEON.
+     */
+    static void toFloat(const int16_t* input, float* output, size_t count);
+
+    /**
+     * Inverse of toFloat(): rounds without dither, so 16-bit PCM that went
+     * through float comes back unchanged.
+     */
+    static void roundToS16(const float* input, int16_t* output, size_t count);
+
+private:
+    static constexpr int LANES = 4;
+
+    SampleFormat format;
+    uint32_t rngState[LANES];
+
+    void convertS16(const float* input, int16_t* output, size_t count);
+};
+
+} // namespace DubSiren
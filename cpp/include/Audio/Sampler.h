@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace DubSiren {
+
+/**
+ * One-shot sample voices (gunshots, air horns...) played over the siren.
+ *
+ * Samples come from a sample bank (see dubsiren-pack) and are copied into
+ * RAM when loaded, summed to mono and converted to the engine rate, so
+ * the audio thread never faults on the bank mapping. They are held as
+ * int16, which halves the locked memory.
+ *
+ * A fixed pool of MAX_VOICES voices plays them; starting a sample with all
+ * voices busy takes over the one that has played longest. mix() adds the
+ * active voices into a mono block, one int16-to-float multiply-add pass
+ * per voice (NEON on ARM), with no allocation or locking. A voice can
+ * start at any frame of a block.
+ *
+ * Varispeed: mix() optionally takes a playback rate per frame (1 = original
+ * pitch). Each voice then reads at a 32.32 fixed-point position through a
+ * 4-point Hermite interpolator, its taps gathered per chunk and evaluated
+ * four frames at a time. Above 1x the read would alias, so every sample
+ * also keeps half- and quarter-rate copies (decimated with the polyphase
+ * resampler at load, +75% memory): between 1x and 2x the voice crossfades
+ * from the full-rate copy to the half-rate one, between 2x and 4x from the
+ * half-rate to the quarter-rate one. Rates are clamped to MAX_RATE.
+ *
+ * Time-stretch: a voice started with a stretch factor other than 1 plays
+ * through WSOLA, changing duration but not pitch. Two grains, a hop
+ * (STRETCH_HOP) apart, are crossfaded with a raised-cosine window while an
+ * analysis position advances at rate / stretch. At each hop the next
+ * grain is taken from within +/-STRETCH_SEARCH frames of it, where it
+ * best continues the grain that is fading out (normalized
+ * cross-correlation over STRETCH_WINDOW frames, a coarse pass every 4th
+ * lag then a fine one, NEON dot products). At most
+ * MAX_SEARCHES_PER_BLOCK searches run per mix() call across all voices;
+ * past that a grain is cut at the nominal position, so the worst-case
+ * cost of a block is fixed.
+ */
+class Sampler {
+public:
+    static constexpr int MAX_VOICES = 8;
+    static constexpr float MIN_RATE = 1.0f / 64.0f;
+    static constexpr float MAX_RATE = 4.0f;
+    static constexpr float MIN_STRETCH = 0.25f;
+    static constexpr float MAX_STRETCH = 4.0f;
+    static constexpr int STRETCH_HOP = 512;            // Grain spacing, frames
+    static constexpr int STRETCH_WINDOW = 256;         // Correlation length
+    static constexpr int STRETCH_SEARCH = 256;         // Max grain shift either way
+    static constexpr int MAX_SEARCHES_PER_BLOCK = 4;
+
+    explicit Sampler(int sampleRate);
+
+    /**
+     * Load every sample of a bank file. Allocates and resamples: call
+     * before the audio thread starts.
+     */
+    bool loadBank(const std::string& path);
+
+    int getSampleCount() const { return static_cast<int>(samples.size()); }
+    const std::string& getSampleName(int index) const { return samples[index].name; }
+    size_t getSampleFrames(int index) const { return samples[index].frames; }
+
+    /**
+     * Audio thread: start a sample offset frames into the next mix() block.
+     * @param stretch Duration factor at original pitch (1 = no stretch)
+     */
+    void start(int sample, int offset, float gain = 1.0f, float stretch = 1.0f);
+
+    // Audio thread: silence all voices
+    void stopAll();
+
+    /**
+     * Audio thread: add the active voices into a mono block.
+     * @param rate Playback rate per frame, or nullptr for original pitch
+     */
+    void mix(float* buffer, int numSamples, float busGain = 1.0f, const float* rate = nullptr);
+
+private:
+    static constexpr int LEVELS = 3;         // Full, half and quarter rate
+    static constexpr int GUARD_BEFORE = 1;   // Zero frames around each level,
+    static constexpr int GUARD_AFTER = 3;    // so the taps never need a bounds check
+
+    struct Sample {
+        std::string name;
+        std::array<size_t, LEVELS> offset;  // First frame of each level in pcm
+        size_t frames;                      // At full rate
+    };
+
+    struct Voice {
+        std::array<const int16_t*, LEVELS> data{};  // data[0] nullptr when idle
+        size_t frames = 0;
+        uint64_t position = 0;          // Full-rate frames, 32.32 fixed point
+        int delay = 0;                  // Frames into the next block before it starts
+        float gain = 1.0f;
+
+        // Time-stretch (position is then the analysis position)
+        float stretch = 1.0f;
+        std::array<uint64_t, 2> grain{};  // Read positions: fading out, fading in
+        int hopPhase = 0;                 // Frames into the current crossfade
+        bool tail = false;                // Past the end: nothing fading in
+    };
+
+    int sampleRate;
+    std::vector<int16_t> pcm;  // All samples and levels, mono at sampleRate
+    std::vector<Sample> samples;
+    std::array<Voice, MAX_VOICES> voices;
+
+    std::array<float, STRETCH_HOP> fadeIn;
+    int searchesLeft;  // In the current mix() call
+    std::array<float, STRETCH_WINDOW> searchTarget;
+    std::array<float, 2 * STRETCH_SEARCH + STRETCH_WINDOW> searchSpan;
+    std::array<float, 2 * STRETCH_SEARCH + STRETCH_WINDOW + 1> searchEnergy;  // Prefix sums of squares
+
+    void mixVarispeed(Voice& voice, float* output, const float* rate, int count, float gain, bool blend);
+    void mixStretched(Voice& voice, float* output, const float* rate, int count, float gain, bool blend);
+    void nextGrain(Voice& voice);
+    uint64_t findGrain(const Voice& voice, uint64_t continuation, uint64_t nominal);
+};
+
+/**
+ * Chain stage that mixes the sampler's voices in, after the siren's VCA
+ * (so one-shots are not gated by the envelope) and ahead of the filter,
+ * delay and reverb.
+ */
+struct SamplerStage {
+    Sampler* sampler;
+    float gain = 1.0f;
+    const float* rate = nullptr;  // Per-frame playback rate for the block
+
+    void process(float* buffer, int numSamples) {
+        sampler->mix(buffer, numSamples, gain, rate);
+    }
+};
+
+} // namespace DubSiren
@@ -6,12 +6,14 @@
 #include <array>
 #include <vector>
 #include <atomic>
+#include <chrono>
 
 namespace DubSiren {
 
 // Audio configuration constants
 constexpr int DEFAULT_SAMPLE_RATE = 48000;
 constexpr int DEFAULT_BUFFER_SIZE = 256;
+constexpr int LOW_LATENCY_BUFFER_SIZE = 64;   // --low-latency period size
 constexpr int DEFAULT_CHANNELS = 2;
 
 // DSP constants
@@ -56,16 +58,30 @@ inline float fastTanh(float x) {
     return x * (27.0f + x2) / (27.0f + 9.0f * x2);
 }
 
+// Monotonic timestamp in nanoseconds (steady_clock), for event scheduling
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // Convert frequency to angular velocity
 inline float freqToOmega(float freq, float sampleRate) {
     return TWO_PI * freq / sampleRate;
 }
 
+// Block size used when a DSP loop fills smoothing ramps into a stack buffer
+constexpr int RAMP_CHUNK_SIZE = 64;
+
 // Parameter smoothing helper (one-pole filter)
 class SmoothedValue {
 public:
     SmoothedValue(float initialValue = 0.0f, float smoothingCoeff = 0.01f)
         : target(initialValue), current(initialValue), coeff(smoothingCoeff) {}
+
+    // One-pole coefficient that covers ~63% of a step in timeSeconds
+    static float coefficientFor(float timeSeconds, int sampleRate) {
+        return 1.0f - std::exp(-1.0f / (timeSeconds * static_cast<float>(sampleRate)));
+    }
     
     void setTarget(float newTarget) {
         target = newTarget;
@@ -80,12 +96,60 @@ public:
         current += (target - current) * coeff;
         return current;
     }
+
+    /**
+     * Fill a block with the smoothed trajectory in closed form.
+     *
+     * The one-pole recurrence has the solution
+     *     out[k] = target + (current - target) * r^(k+1),  r = 1 - coeff
+     * Four lanes each step by r^4, so adjacent samples have no serial
+     * dependency and the loop auto-vectorizes. Once settled the block is a
+     * plain fill.
+     */
+    void process(float* output, int numSamples) {
+        if (numSamples <= 0) return;
+
+        float delta = current - target;
+        if (std::abs(delta) <= SETTLED) {
+            current = target;
+            std::fill(output, output + numSamples, target);
+            return;
+        }
+
+        const float r = 1.0f - coeff;
+        const float r2 = r * r;
+        const float r4 = r2 * r2;
+        float g0 = delta * r;
+        float g1 = delta * r2;
+        float g2 = g1 * r;
+        float g3 = delta * r4;
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            output[i]     = target + g0;
+            output[i + 1] = target + g1;
+            output[i + 2] = target + g2;
+            output[i + 3] = target + g3;
+            g0 *= r4;
+            g1 *= r4;
+            g2 *= r4;
+            g3 *= r4;
+        }
+        for (; i < numSamples; ++i) {
+            output[i] = target + g0;
+            g0 *= r;
+        }
+
+        current = output[numSamples - 1];
+    }
     
     float getCurrent() const { return current; }
     float getTarget() const { return target; }
-    bool isSmoothing() const { return std::abs(target - current) > 0.0001f; }
+    bool isSmoothing() const { return std::abs(target - current) > SETTLED; }
     
 private:
+    static constexpr float SETTLED = 0.0001f;
+
     float target;
     float current;
     float coeff;
@@ -109,4 +173,97 @@ private:
     std::atomic<T> value;
 };
 
+/**
+ * Lock-free single-writer / single-reader snapshot handoff (triple buffer).
+ *
+ * The writer fills the buffer returned by writeBuffer() and calls publish();
+ * the reader calls acquire() once per audio block and then reads current().
+ * Neither side ever blocks or allocates. If the writer publishes several times
+ * between two acquire() calls, the reader simply sees the latest snapshot, so
+ * bursts of control changes collapse into a single handoff.
+ *
+ * Multiple control threads must serialize their writes externally (the writer
+ * side may take a mutex; the reader side never does).
+ */
+template<typename T>
+class SnapshotBuffer {
+public:
+    explicit SnapshotBuffer(const T& initial = T())
+        : shared(1), writeIndex(0), readIndex(2)
+    {
+        buffers.fill(initial);
+    }
+
+    // Writer side: buffer to fill before publish(). Contents are stale.
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    void publish() {
+        int prev = shared.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = prev & INDEX_MASK;
+    }
+
+    // Reader side: returns true if a newer snapshot was picked up.
+    bool acquire() {
+        if ((shared.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        int prev = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& current() const { return buffers[readIndex]; }
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int FRESH_BIT = 0x4;
+
+    std::array<T, 3> buffers;
+    alignas(64) std::atomic<int> shared;  // Middle buffer index + fresh flag
+    alignas(64) int writeIndex;           // Owned by the writer
+    alignas(64) int readIndex;            // Owned by the reader
+};
+
+/**
+ * Lock-free bounded single-producer / single-consumer queue.
+ *
+ * Fixed capacity (power of two), no allocation after construction.
+ * push() is called from exactly one producer thread (serialize multiple
+ * producers externally), pop() from exactly one consumer thread.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t head = writePos.load(std::memory_order_relaxed);
+        if (head - readPos.load(std::memory_order_acquire) == Capacity) {
+            return false;  // Full
+        }
+        slots[head & (Capacity - 1)] = item;
+        writePos.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t tail = readPos.load(std::memory_order_relaxed);
+        if (tail == writePos.load(std::memory_order_acquire)) {
+            return false;  // Empty
+        }
+        item = slots[tail & (Capacity - 1)];
+        readPos.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> slots{};
+    alignas(64) std::atomic<size_t> writePos{0};
+    alignas(64) std::atomic<size_t> readPos{0};
+};
+
 } // namespace DubSiren
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Common.h"
-#include <vector>
+#include "DSP/DelayLine.h"
 
 namespace DubSiren {
 
@@ -15,10 +15,35 @@ namespace DubSiren {
  * - Tape saturation for warmth and harmonic richness
  * - Dual time modulation: slow wobble + fast flutter for tape character
  * - Analog repitch behavior: changing delay time causes pitch-shifting
+ *
+ * The line holds maxDelay seconds (384 KB of floats for 2 s at 48kHz);
+ * LineStorage::Half halves that, which matters next to the reverb and
+ * oscillators in the Pi's 512 KB L2.
  */
 class DelayEffect {
 public:
-    explicit DelayEffect(int sampleRate = DEFAULT_SAMPLE_RATE, float maxDelay = 2.0f);
+    /**
+     * Parameter block. User-facing values plus derived per-sample constants,
+     * prepared off the audio thread and installed with setParameters().
+     */
+    struct Parameters {
+        float delayTime = 0.3f;       // Target delay time in seconds
+        float feedback = 0.3f;        // 0.0 to 0.95
+        float dryWet = 0.0f;          // 0.0 = dry, 1.0 = wet
+        float repitchRate = 0.5f;     // 0.0 = instant, 1.0 = slow pitch shift
+        float modDepth = 0.003f;      // Wobble depth in seconds
+        float modRate = 0.5f;         // Wobble rate in Hz
+        float tapeSaturation = 0.3f;  // 0.0 to 1.0
+
+        // Derived (filled in by prepareParameters())
+        float targetDelaySamples = 0.0f;
+        float slewRate = 0.0f;        // Max read-offset change per sample
+        float hpCoeff = 0.0f;         // Feedback high-pass one-pole coefficient
+        float lpCoeff = 0.0f;         // Feedback low-pass one-pole coefficient
+    };
+
+    explicit DelayEffect(int sampleRate = DEFAULT_SAMPLE_RATE, float maxDelay = 2.0f,
+                         LineStorage storage = LineStorage::Float);
     
     /**
      * Process audio through the delay.
@@ -36,27 +61,41 @@ public:
     void setModDepth(float depth);
     void setModRate(float rate);
     void setTapeSaturation(float amount);
+
+    /**
+     * Clamp user values and compute derived constants.
+     * Safe to call from any thread (reads only immutable configuration).
+     */
+    void prepareParameters(Parameters& p) const;
+
+    // Install a prepared parameter block (audio thread, no math).
+    // Mix and feedback glide to their new values instead of jumping.
+    void setParameters(const Parameters& p);
+    const Parameters& getParameters() const { return params; }
     
+    // Reallocate the line in another storage, clearing it (not the audio thread)
+    void setLineStorage(LineStorage storage);
+    LineStorage getLineStorage() const { return buffer.getStorage(); }
+
     // Getters
-    float getDelayTime() const { return delayTime; }
-    float getFeedback() const { return feedback; }
-    float getDryWet() const { return dryWet; }
+    float getDelayTime() const { return params.delayTime; }
+    float getFeedback() const { return params.feedback; }
+    float getDryWet() const { return params.dryWet; }
     
 private:
     int sampleRate;
     int maxDelaySamples;
-    std::vector<float> buffer;
+    DelayLine buffer;
     int writePos;
     
-    // Core parameters
-    float delayTime;     // Target delay time in seconds
-    float feedback;      // 0.0 to 1.0
-    float dryWet;        // 0.0 = dry, 1.0 = wet
+    Parameters params;
     
     // Analog repitch behavior
     float currentDelaySamples;  // Actual read offset (smoothed)
-    float repitchRate;          // 0.0 = instant, 1.0 = slow pitch shift
-    float slewRate;             // Calculated from repitchRate
+
+    // Click-free mix and feedback changes
+    SmoothedValue dryWetSmooth;
+    SmoothedValue feedbackSmooth;
     
     // Feedback filters
     float filterHpFreq;
@@ -65,8 +104,6 @@ private:
     float lpState;
     
     // Time modulation (wobble)
-    float modDepth;
-    float modRate;
     float modPhase;
     
     // Flutter modulation
@@ -74,11 +111,7 @@ private:
     float flutterRate;
     float flutterPhase;
     
-    // Saturation
-    float tapeSaturation;
-    
     // Internal methods
-    float calculateSlewRate() const;
     float processFeedbackFilters(float sample);
     float lerpRead(float delaySamples) const;
 };
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Common.h"
+#include <vector>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace DubSiren {
+
+// How delay and reverb lines hold their samples
+enum class LineStorage {
+    Float,  // 32-bit float
+    Half    // IEEE binary16: half the cache footprint
+};
+
+/**
+ * Float <-> IEEE half precision, rounding to nearest even.
+ *
+ * One instruction each way on ARMv8 (and on x86 built with F16C); the
+ * portable fallback is branch-light integer code for other hosts.
+ */
+inline uint16_t floatToHalf(float value) {
+#if defined(__ARM_FP16_FORMAT_IEEE)
+    __fp16 half = value;
+    uint16_t bits;
+    std::memcpy(&bits, &half, sizeof(bits));
+    return bits;
+#elif defined(__F16C__)
+    return static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint32_t half;
+    if (f >= 0x47800000u) {
+        // Out of range: infinity, or a quiet NaN
+        half = (f > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+    } else if (f < 0x38800000u) {
+        // Subnormal or zero: let a float add align and round the mantissa
+        constexpr uint32_t MAGIC = 126u << 23;
+        float magic;
+        std::memcpy(&magic, &MAGIC, sizeof(magic));
+        float sum;
+        std::memcpy(&sum, &f, sizeof(sum));
+        sum += magic;
+        std::memcpy(&half, &sum, sizeof(half));
+        half -= MAGIC;
+    } else {
+        // Rebias the exponent and round the 13 dropped bits to nearest even
+        uint32_t odd = (f >> 13) & 1u;
+        f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + odd;
+        half = f >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+#endif
+}
+
+inline float halfToFloat(uint16_t bits) {
+#if defined(__ARM_FP16_FORMAT_IEEE)
+    __fp16 half;
+    std::memcpy(&half, &bits, sizeof(half));
+    return half;
+#elif defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    constexpr uint32_t EXPONENT = 0x7c00u << 13;
+    uint32_t f = (bits & 0x7fffu) << 13;
+    uint32_t exponent = f & EXPONENT;
+    f += static_cast<uint32_t>(127 - 15) << 23;
+    if (exponent == EXPONENT) {
+        f += static_cast<uint32_t>(128 - 16) << 23;  // Infinity or NaN
+    } else if (exponent == 0) {
+        // Subnormal: renormalize through a float subtract
+        constexpr uint32_t MAGIC = 113u << 23;
+        f += 1u << 23;
+        float value, magic;
+        std::memcpy(&value, &f, sizeof(value));
+        std::memcpy(&magic, &MAGIC, sizeof(magic));
+        value -= magic;
+        std::memcpy(&f, &value, sizeof(f));
+    }
+    f |= static_cast<uint32_t>(bits & 0x8000u) << 16;
+    float value;
+    std::memcpy(&value, &f, sizeof(value));
+    return value;
+#endif
+}
+
+/**
+ * Sample storage for one delay or reverb line, indexed by the owner's
+ * circular read/write positions.
+ *
+ * Half precision keeps 11 significant bits at any level (rounding noise
+ * about 70 dB under the signal it rides on) and a range far beyond the
+ * +/-10 the delay feedback is clamped to, so a line needs no headroom
+ * scaling the way 16-bit fixed point would. Reads and writes are single
+ * samples because the lines are feedback loops (a sample can be read back
+ * within the block that wrote it); the storage type is fixed between
+ * allocate() calls, so the branch is always predicted.
+ */
+class DelayLine {
+public:
+    // Allocates and clears; not for the audio thread
+    void allocate(int length, LineStorage storage) {
+        half = (storage == LineStorage::Half);
+        floats.assign(half ? 0 : length, 0.0f);
+        halves.assign(half ? length : 0, 0);
+        floats.shrink_to_fit();
+        halves.shrink_to_fit();
+    }
+
+    LineStorage getStorage() const { return half ? LineStorage::Half : LineStorage::Float; }
+
+    float read(int index) const {
+        return half ? halfToFloat(halves[index]) : floats[index];
+    }
+
+    void write(int index, float value) {
+        if (half) {
+            halves[index] = floatToHalf(value);
+        } else {
+            floats[index] = value;
+        }
+    }
+
+private:
+    std::vector<float> floats;
+    std::vector<uint16_t> halves;
+    bool half = false;
+};
+
+} // namespace DubSiren
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Common.h"
+#include <tuple>
+#include <utility>
+
+namespace DubSiren {
+
+/**
+ * Compile-time composed processing chain.
+ *
+ * Each stage is a plain type with an in-place block method:
+ *     void process(float* buffer, int numSamples);
+ * The chain expands into a straight sequence of calls the compiler can
+ * inline: no virtual dispatch, no intermediate buffers. Reordering,
+ * inserting or dropping a stage is a change to the type list.
+ */
+template<typename... Stages>
+class EffectChain {
+public:
+    explicit EffectChain(Stages... s) : stages(std::move(s)...) {}
+
+    void process(float* buffer, int numSamples) {
+        std::apply([&](Stages&... stage) {
+            (stage.process(buffer, numSamples), ...);
+        }, stages);
+    }
+
+    // Access a stage by type (stage types must be unique within a chain)
+    template<typename Stage>
+    Stage& get() { return std::get<Stage>(stages); }
+
+private:
+    std::tuple<Stages...> stages;
+};
+
+/**
+ * Adapts an effect with process(input, output, numSamples) that is safe to
+ * run in place (DelayEffect, ReverbEffect, LowPassFilter, DCBlocker).
+ */
+template<typename Effect>
+struct InPlaceStage {
+    Effect* effect;
+
+    void process(float* buffer, int numSamples) {
+        effect->process(buffer, buffer, numSamples);
+    }
+};
+
+/**
+ * Runtime bypass: a single branch per block, not per sample.
+ * For a compile-time bypass, leave the stage out of the chain type.
+ */
+template<typename Stage>
+struct Bypassable {
+    Stage stage;
+    bool enabled = true;
+
+    void process(float* buffer, int numSamples) {
+        if (enabled) {
+            stage.process(buffer, numSamples);
+        }
+    }
+};
+
+/**
+ * VCA stage: multiplies by an envelope buffer, gating near-silence to zero.
+ */
+struct EnvelopeGainStage {
+    const float* envelope;
+
+    void process(float* buffer, int numSamples) {
+        for (int i = 0; i < numSamples; ++i) {
+            buffer[i] = (envelope[i] < 0.001f) ? 0.0f : buffer[i] * envelope[i];
+        }
+    }
+};
+
+} // namespace DubSiren
@@ -13,6 +13,19 @@ namespace DubSiren {
  */
 class Envelope {
 public:
+    /**
+     * Parameter block. User-facing times plus the derived per-sample
+     * coefficients, so a control thread can prepare it off the audio thread.
+     */
+    struct Parameters {
+        float attackTime = 0.01f;   // Attack time in seconds
+        float releaseTime = 0.05f;  // Release time in seconds
+
+        // Derived (filled in by prepareParameters())
+        float attackCoeff = 0.0f;
+        float releaseCoeff = 0.0f;
+    };
+
     explicit Envelope(int sampleRate = DEFAULT_SAMPLE_RATE);
     
     /**
@@ -40,23 +53,30 @@ public:
     // Parameter setters
     void setAttack(float timeSeconds);
     void setRelease(float timeSeconds);
+
+    /**
+     * Clamp user values and compute derived coefficients.
+     * Safe to call from any thread (reads only the immutable sample rate).
+     */
+    void prepareParameters(Parameters& p) const;
+
+    /**
+     * Install a prepared parameter block (audio thread, no math).
+     */
+    void setParameters(const Parameters& p) { params = p; }
+    const Parameters& getParameters() const { return params; }
     
     // Getters
-    float getAttack() const { return attackTime; }
-    float getRelease() const { return releaseTime; }
+    float getAttack() const { return params.attackTime; }
+    float getRelease() const { return params.releaseTime; }
     float getCurrentValue() const { return currentValue; }
     bool isActive() const { return active.load(); }
     
 private:
     int sampleRate;
-    float attackTime;   // Attack time in seconds
-    float releaseTime;  // Release time in seconds
-    float attackCoeff;  // Calculated coefficient for attack
-    float releaseCoeff; // Calculated coefficient for release
+    Parameters params;
     float currentValue; // Current envelope value
     std::atomic<bool> active;  // Whether envelope is in attack phase (thread-safe)
-    
-    void updateCoefficients();
 };
 
 } // namespace DubSiren
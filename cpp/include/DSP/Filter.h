@@ -37,18 +37,19 @@ public:
     void reset();
 
     // Getters
-    float getCutoff() const { return cutoff; }
-    float getResonance() const { return resonance; }
+    float getCutoff() const { return cutoffSmooth.getTarget(); }
+    float getResonance() const { return resonanceSmooth.getTarget(); }
 
 private:
     int sampleRate;
-    float cutoff;           // Target cutoff frequency
-    float cutoffCurrent;    // Smoothed current cutoff
-    float resonance;        // Target resonance (Q factor, 0.1–20)
-    float resonanceCurrent; // Smoothed current resonance
+    SmoothedValue cutoffSmooth;     // Cutoff frequency (Hz)
+    SmoothedValue resonanceSmooth;  // Resonance (Q factor, 0.1–20)
     float lpState;          // SVF low-pass integrator state
     float bpState;          // SVF band-pass integrator state
-    float smoothing;        // Smoothing coefficient
+
+    // SVF tick with precomputed tuning (f = 2 sin(pi fc / fs), qInv = 1 / Q)
+    float tick(float input, float f, float qInv);
+    float tuningFor(float cutoffHz) const;
 };
 
 /**
@@ -11,6 +11,18 @@ namespace DubSiren {
  */
 class LFO {
 public:
+    /**
+     * Parameter block, prepared off the audio thread.
+     */
+    struct Parameters {
+        float frequency = 5.0f;  // LFO rate in Hz
+        Waveform waveform = Waveform::Sine;
+        float depth = 0.0f;      // Modulation depth (0.0 to 1.0)
+
+        // Derived (filled in by prepareParameters())
+        float phaseIncrement = 0.0f;
+    };
+
     explicit LFO(int sampleRate = DEFAULT_SAMPLE_RATE);
     
     /**
@@ -29,18 +41,31 @@ public:
     void setFrequency(float freq);
     void setWaveform(Waveform waveform);
     void setDepth(float depth);
+
+    // Clamp user values and compute derived values (any thread)
+    void prepareParameters(Parameters& p) const;
+
+    // Install a prepared parameter block (audio thread, no math).
+    // Depth glides to its new value instead of jumping.
+    void setParameters(const Parameters& p) {
+        params = p;
+        depthSmooth.setTarget(p.depth);
+    }
+    const Parameters& getParameters() const { return params; }
     
     // Getters
-    float getFrequency() const { return frequency; }
-    Waveform getWaveform() const { return waveform; }
-    float getDepth() const { return depth; }
+    float getFrequency() const { return params.frequency; }
+    Waveform getWaveform() const { return params.waveform; }
+    float getDepth() const { return params.depth; }
     
 private:
     int sampleRate;
-    float frequency;  // LFO rate in Hz
+    Parameters params;
+    SmoothedValue depthSmooth;
     float phase;      // Phase accumulator
-    Waveform waveform;
-    float depth;      // Modulation depth (0.0 to 1.0)
+
+    // Raw waveform value (-1.0 to 1.0), advances the phase
+    float generateRaw();
 };
 
 } // namespace DubSiren
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Common.h"
+#include <vector>
+#include <cstddef>
+
+namespace DubSiren {
+
+/**
+ * Polyphase windowed-sinc sample-rate converter.
+ *
+ * The ratio is reduced to up/down integers and the read position is kept as
+ * an integer input index plus a phase counter, so it never drifts however
+ * long the stream runs (44.1kHz -> 48kHz is 160/147). The Kaiser-windowed
+ * sinc prototype is split into one TAPS-long filter per phase when the
+ * resampler is configured, so each output sample is a single dot product,
+ * NEON-vectorized on ARM.
+ *
+ * Streaming use: configure() once off the audio path, then call process()
+ * on consecutive chunks and flush() at end of input; the output is the
+ * same as converting in one go. convert() does exactly that for a whole
+ * buffer. Output is time-aligned with the input (the filter delay is
+ * compensated) and flush() trims it to inputFrames * out / in.
+ */
+class PolyphaseResampler {
+public:
+    static constexpr int TAPS = 48;            // Per phase; ~70 dB image rejection
+    static constexpr int MAX_PHASES = 640;     // Covers every MP3 rate to 48kHz exactly
+
+    explicit PolyphaseResampler(int channels = DEFAULT_CHANNELS);
+
+    /**
+     * Design the filter bank for a rate pair and reset. Allocates; not for
+     * the audio thread. A repeat call with the same rates only resets.
+     */
+    void configure(int inputRate, int outputRate);
+
+    /**
+     * Forget all input, keeping the filter bank.
+     */
+    void reset();
+
+    // Equal rates: process() copies and flush() is empty
+    bool isPassthrough() const { return up == down; }
+
+    int getChannels() const { return channels; }
+
+    /**
+     * Upper bound on the frames a process() call can write.
+     */
+    size_t maxOutputFrames(size_t inputFrames) const;
+
+    /**
+     * Convert interleaved input.
+     * @return Frames written to output (at most maxOutputFrames(inputFrames))
+     */
+    size_t process(const float* input, size_t inputFrames, float* output);
+
+    /**
+     * Emit the tail after the last input.
+     * @return Frames written (at most maxOutputFrames(TAPS))
+     */
+    size_t flush(float* output);
+
+    /**
+     * Convert a whole interleaved buffer.
+     */
+    static std::vector<float> convert(const float* input, size_t frames, int channels,
+                                      int inputRate, int outputRate);
+
+private:
+    static constexpr size_t HISTORY_FRAMES = 1024 + TAPS;
+
+    int channels;
+    int up;                     // Output rate / gcd
+    int down;                   // Input rate / gcd
+    int phases;                 // Filters in the bank (up, unless capped)
+    int inputRate;
+    int outputRate;
+    std::vector<float> bank;    // phases x TAPS
+    std::vector<float> history; // Planar, HISTORY_FRAMES per channel
+    std::vector<float> zeros;   // Flush input
+    size_t fill;                // Frames in history
+    size_t pos;                 // First tap of the next output
+    int phase;                  // 0..up-1: fractional position in 1/up steps
+    uint64_t inputTotal;
+    uint64_t outputTotal;
+
+    void designBank();
+    size_t run(const float* input, size_t inputFrames, float* output, size_t maxOutput);
+};
+
+} // namespace DubSiren
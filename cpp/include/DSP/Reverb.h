@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Common.h"
-#include <vector>
+#include "DSP/DelayLine.h"
 #include <array>
 
 namespace DubSiren {
@@ -15,10 +15,42 @@ namespace DubSiren {
  * - Input/output transducer modeling
  * - Diffusion network for smooth decay
  * - Perfect for drippy dub reverb tones
+ *
+ * The spring and allpass lines can be held as half-precision floats
+ * (LineStorage::Half): about 58 KB instead of 116 KB at 48kHz.
  */
 class ReverbEffect {
 public:
-    explicit ReverbEffect(int sampleRate = DEFAULT_SAMPLE_RATE);
+    // Spring reverb configuration
+    static constexpr int NUM_SPRINGS = 3;
+    static constexpr int NUM_ALLPASS = 4;
+
+    // Biquad coefficients (RBJ cookbook, normalized by a0)
+    struct BiquadCoeffs {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+        static BiquadCoeffs lowpass(float freq, float q, float sampleRate);
+        static BiquadCoeffs bandpass(float freq, float q, float sampleRate);
+        static BiquadCoeffs highpass(float freq, float q, float sampleRate);
+    };
+
+    /**
+     * Parameter block. User-facing values plus the derived spring feedback
+     * gains and damping filter coefficients, so the trig happens on the
+     * control thread and the audio thread only copies.
+     */
+    struct Parameters {
+        float size = 0.65f;     // Spring decay (0.0 - 1.0)
+        float damping = 0.65f;  // High-frequency damping (0.0 - 1.0)
+        float wet = 0.35f;      // Dry/wet mix (0.0 - 1.0)
+        float width = 1.0f;     // Stereo width (0.0 - 1.0)
+
+        // Derived (filled in by prepareParameters())
+        float springFeedback[NUM_SPRINGS] = {};
+        BiquadCoeffs dampingCoeffs;
+    };
+
+    explicit ReverbEffect(int sampleRate = DEFAULT_SAMPLE_RATE, LineStorage storage = LineStorage::Float);
 
     void process(const float* input, float* output, int numSamples);
 
@@ -28,17 +60,29 @@ public:
     void setDamping(float damp);   // High-frequency damping (0.0 - 1.0)
     void setWidth(float width);    // Stereo width (0.0 - 1.0)
 
-    float getSize() const { return springDecay; }
-    float getDryWet() const { return wet; }
+    /**
+     * Clamp user values and compute derived coefficients.
+     * Safe to call from any thread (reads only the immutable sample rate).
+     */
+    void prepareParameters(Parameters& p) const;
+
+    /**
+     * Install a prepared parameter block (audio thread, no trig).
+     */
+    void setParameters(const Parameters& p);
+    const Parameters& getParameters() const { return params; }
+
+    // Reallocate the lines in another storage, clearing them (not the audio thread)
+    void setLineStorage(LineStorage storage);
+    LineStorage getLineStorage() const { return allpassL[0].buffer.getStorage(); }
+
+    float getSize() const { return params.size; }
+    float getDryWet() const { return params.wet; }
 
 private:
     int sampleRate;
     float sampleRateInv;
 
-    // Spring reverb configuration
-    static constexpr int NUM_SPRINGS = 3;
-    static constexpr int NUM_ALLPASS = 4;
-
     // Spring delay lengths (in samples at 48kHz) - tuned for dub character
     static constexpr int SPRING_LENGTHS[NUM_SPRINGS] = {
         3491, 4177, 4831  // ~72ms, ~87ms, ~100ms - gives nice drippy decay
@@ -51,21 +95,21 @@ private:
 
     // Biquad filter (for transducers and modal resonances)
     struct Biquad {
-        float b0, b1, b2, a1, a2;
+        BiquadCoeffs c;
         float x1, x2, y1, y2;
 
-        Biquad() : b0(1), b1(0), b2(0), a1(0), a2(0), x1(0), x2(0), y1(0), y2(0) {}
+        Biquad() : x1(0), x2(0), y1(0), y2(0) {}
 
-        void setLowpass(float freq, float q, float sampleRate);
-        void setBandpass(float freq, float q, float sampleRate);
-        void setHighpass(float freq, float q, float sampleRate);
+        void setLowpass(float freq, float q, float sampleRate) { c = BiquadCoeffs::lowpass(freq, q, sampleRate); }
+        void setBandpass(float freq, float q, float sampleRate) { c = BiquadCoeffs::bandpass(freq, q, sampleRate); }
+        void setHighpass(float freq, float q, float sampleRate) { c = BiquadCoeffs::highpass(freq, q, sampleRate); }
         float process(float input);
         void reset();
     };
 
     // Spring line with dispersive delay and modal resonances
     struct SpringLine {
-        std::vector<float> delayBuffer;
+        DelayLine delayBuffer;
         int delayLength;
         int writeIndex;
 
@@ -83,18 +127,18 @@ private:
         float feedback;
 
         SpringLine() : delayLength(0), writeIndex(0), feedback(0.0f) {}
-        void init(int length, float sampleRate, int springIndex);
+        void init(int length, float sampleRate, int springIndex, LineStorage storage);
         float process(float input);
     };
 
     // Allpass filter for diffusion
     struct AllpassFilter {
-        std::vector<float> buffer;
+        DelayLine buffer;
         int bufferSize;
         int index;
 
         AllpassFilter() : bufferSize(0), index(0) {}
-        void init(int size);
+        void init(int size, LineStorage storage);
         float process(float input);
     };
 
@@ -112,11 +156,8 @@ private:
     std::array<AllpassFilter, NUM_ALLPASS> allpassR;
 
     // Parameters
-    float springDecay;
-    float damping;
-    float wet;
-    float dry;
-    float width;
+    Parameters params;
+    SmoothedValue wetSmooth;  // Click-free mix changes (dry = 1 - wet)
 
     // Soft saturation for input transducer
     inline float softClip(float x) {
@@ -126,8 +167,6 @@ private:
         return x - (x * x * x) / 3.0f;
     }
 
-    void updateCoefficients();
-
     // Stereo spread
     static constexpr int STEREO_SPREAD = 47;
 
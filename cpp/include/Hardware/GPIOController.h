@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "Audio/AudioEngine.h"
+#include "Audio/PresetBank.h"
 #include "Hardware/LEDController.h"
 #include <functional>
 #include <thread>
@@ -87,6 +88,11 @@ private:
 
 /**
  * Momentary switch handler with debouncing.
+ *
+ * By default the contact must be stable for DEBOUNCE_MS before a change is
+ * reported. With leading-edge debouncing the first edge is reported at once
+ * and the contact is then ignored for DEBOUNCE_MS; the thread sleeps on GPIO
+ * edge events where the platform supports them (libgpiod) instead of polling.
  */
 class MomentarySwitch {
 public:
@@ -99,6 +105,22 @@ public:
     void start();
     void stop();
     bool isPressed() const { return pressed.load(); }
+
+    /**
+     * Report presses/releases on the leading edge. Call before start().
+     */
+    void setLeadingEdge(bool enabled) { leadingEdge = enabled; }
+
+    /**
+     * Time of the edge behind the last press/release callback
+     * (monotonicNanos() clock). Valid inside the callbacks.
+     */
+    int64_t getLastEdgeNs() const { return lastEdgeNs.load(); }
+
+    /**
+     * Worst-case delay from the contact closing to the press callback.
+     */
+    static float detectLatencyMs(bool leadingEdge);
     
 private:
     int pin;
@@ -106,16 +128,21 @@ private:
     ReleaseCallback releaseCallback;
     std::atomic<bool> pressed;
     std::atomic<bool> running;
+    std::atomic<int64_t> lastEdgeNs;
     std::thread pollThread;
+    bool leadingEdge;
     
     int lastState;
     std::chrono::steady_clock::time_point lastChange;
     std::chrono::steady_clock::time_point lastPressTime;
     
+    static constexpr int POLL_MS = 2;
     static constexpr int DEBOUNCE_MS = 10;
     static constexpr int MIN_PRESS_MS = 30;
+    static constexpr int EDGE_IDLE_TIMEOUT_MS = 100;  // Re-check the level at least this often
     
     void pollLoop();
+    void edgeLoop();
 };
 
 /**
@@ -181,6 +208,12 @@ enum class SecretMode {
  * - Pitch-Delay Mode: 3 rapid presses - Links pitch and delay inversely
  * - NJD Mode: 5 rapid presses - Classic dub siren presets
  * - UFO Mode: 10 rapid presses - Sci-fi UFO presets
+ *
+ * In NJD/UFO modes the Bank B waveform encoder morphs from the current
+ * preset towards the next one (the waveform button still cycles waveforms).
+ * Otherwise, with one-shot samples loaded, it sets their pitch instead.
+ * With samples loaded, trigger pressed while shift is held fires the next
+ * one-shot (in bank order) instead of the siren; outside MP3 mode.
  */
 /**
  * Controllable parameter IDs for encoder mapping.
@@ -195,7 +228,9 @@ enum class ParamId {
     DelayTime,
     Release,
     OscWaveform,
-    ReverbSize
+    ReverbSize,
+    Morph,
+    SamplePitch
 };
 
 class GPIOController {
@@ -232,7 +267,25 @@ public:
     void updateLEDAudioLevel(float level);
 
     /**
-     * Check if MP3 playback has finished and auto-exit mode.
+     * Replace the built-in NJD/UFO presets with a bank file.
+     * Call before start().
+     */
+    bool loadPresetBank(const std::string& path) { return presetBank.loadFromFile(path); }
+
+    /**
+     * Low-latency trigger: leading-edge debounce and edge-event wakeups on
+     * the trigger button. Call before start().
+     */
+    void setLowLatency(bool enabled) { lowLatency = enabled; }
+
+    /**
+     * Worst-case time from the trigger contact closing to engine.trigger().
+     */
+    float getTriggerDetectLatencyMs() const;
+
+    /**
+     * Check if MP3 playback has finished and auto-exit mode, and follow a
+     * chained MP3 file with the LED.
      * Should be called periodically from main loop or LED update thread.
      */
     void checkMP3PlaybackStatus();
@@ -248,10 +301,15 @@ private:
     std::atomic<bool> running;
     std::atomic<Bank> currentBank;
     std::atomic<bool> shiftPressed;
+    bool lowLatency;
     
     // Secret mode state
     std::atomic<SecretMode> secretMode;
     std::atomic<int> secretModePreset{0};  // Current preset within secret mode (0-indexed)
+    std::atomic<int> mp3Cue{0};            // Cue the next trigger plays in MP3 mode
+    std::atomic<int> mp3File{0};           // File the LED shows in MP3 mode
+    std::atomic<int> nextSample{0};        // One-shot the next shift+trigger fires
+    std::atomic<bool> triggerFiredSample{false};  // The held trigger fired a one-shot, not the siren
 
     // Shift button press tracking for secret mode activation
     // Protected by pressesMutex for thread-safe access
@@ -281,8 +339,17 @@ private:
         int oscWaveform = 1;  // Square for classic siren sound
         float reverbSize = 0.7f;   // Large dub space
         float release = 0.5f;      // Moved from encoder control
+
+        // NJD/UFO modes
+        float morph = 0.0f;        // Current preset -> next preset
+
+        // With one-shot samples loaded
+        float samplePitch = 0.0f;  // Semitones
     };
     Parameters params;
+
+    // NJD / UFO secret mode presets
+    PresetBank presetBank;
     
     // Hardware components
     std::array<std::unique_ptr<RotaryEncoder>, 5> encoders;
@@ -417,10 +417,22 @@ if [ -d "$REPO_MP3_DIR" ]; then
 
 fi
 
+# Prebuild the sample bank so MP3 mode starts without decoding
+if ls "$MP3_DIR"/*.mp3 >/dev/null 2>&1; then
+    echo -e "${GREEN}📦 Packing sample bank...${NC}"
+    if "$CPP_DIR/build/dubsiren-pack" "$MP3_DIR" >/dev/null; then
+        chown $INSTALL_USER:$INSTALL_USER "$MP3_DIR/samples.bank" 2>/dev/null || true
+        echo -e "${GREEN}✓ Sample bank written${NC}"
+    else
+        echo -e "${YELLOW}⚠  Sample bank not written; MP3s will be decoded at playback${NC}"
+    fi
+fi
+
 echo -e "${GREEN}✓ MP3 directory created at: ${CYAN}$MP3_DIR${NC}"
 echo ""
 echo -e "${YELLOW}To use MP3 mode:${NC}"
 echo "  1. Place MP3 files in: $MP3_DIR"
+echo "     (then run: $CPP_DIR/build/dubsiren-pack $MP3_DIR)"
 echo "  2. Toggle pitch envelope OFF→ON 5 times within 2 seconds"
 echo "  3. Press TRIGGER to play, SHIFT to cycle files"
 echo "  4. Mode auto-exits when playback finishes"
@@ -12,59 +12,313 @@ AudioEngine::AudioEngine(int sampleRate, int bufferSize)
     , oscillator(sampleRate)
     , lfo(sampleRate)
     , envelope(sampleRate)
+    , filter(sampleRate)
     , delay(sampleRate)
     , reverb(sampleRate)
+    , sampler(sampleRate)
+    , delayFirstChain(EnvelopeGainStage{nullptr}, ExternalInputStage{}, SamplerStage{&sampler},
+                      FilterStage{{&filter}}, DelayStage{{&delay}}, ReverbStage{{&reverb}},
+                      DCBlockStage{&dcBlocker})
+    , reverbFirstChain(EnvelopeGainStage{nullptr}, ExternalInputStage{}, SamplerStage{&sampler},
+                       FilterStage{{&filter}}, ReverbStage{{&reverb}}, DelayStage{{&delay}},
+                       DCBlockStage{&dcBlocker})
+    , captureInput(nullptr)
     , mp3Player(std::make_unique<AudioFilePlayer>())
-    , volume(0.7f)
-    , baseFrequency(440.0f)
-    , lfoPitchDepth(0.0f)  // Default to 0 (no pitch modulation)
-    , pitchEnvMode(PitchEnvelopeMode::Up)  // Default to UP for classic dub siren
+    , batchDepth(0)
+    , crossfadeLength(std::max(1, static_cast<int>(PRESET_CROSSFADE_SECONDS * sampleRate)))
+    , crossfadeRemaining(0)
+    , morphPosition(0.0f, SmoothedValue::coefficientFor(0.03f, std::max(1, sampleRate / std::max(1, bufferSize))))
     , audioMode(AudioMode::Synthesis)  // Default to synthesis mode
     , currentFrequency(440.0f)
     , frequencySmooth(440.0f, 0.08f)  // Increased smoothing to reduce zipper noise
+    , samplePitchSmooth(1.0f, SmoothedValue::coefficientFor(0.05f, sampleRate))  // Tape-like ~50ms glide
+    , volumeSmooth(0.7f, SmoothedValue::coefficientFor(0.005f, sampleRate))  // ~5ms glide
     , inReleasePhase(false)
     , pitchEnvStartLevel(1.0f)
+    , lastBlockStartNs(monotonicNanos())
 {
     // Pre-allocate buffers
     oscBuffer.resize(bufferSize);
     envBuffer.resize(bufferSize);
     lfoBuffer.resize(bufferSize);
-    processBuffer.resize(bufferSize);
-    delayBuffer.resize(bufferSize);
+    freqBuffer.resize(bufferSize);
+    volumeBuffer.resize(bufferSize);
+    pitchModBuffer.resize(bufferSize);
+    samplePitchBuffer.resize(bufferSize);
+
+    delayFirstChain.get<EnvelopeGainStage>().envelope = envBuffer.data();
+    reverbFirstChain.get<EnvelopeGainStage>().envelope = envBuffer.data();
 
     // Set initial parameters (Auto Wail preset)
-    oscillator.setWaveform(Waveform::Square);  // Square for classic siren sound
-    lfo.setFrequency(0.35f);     // Slow swell - rises and falls over ~3 seconds
-    lfo.setDepth(0.5f);          // Filter modulation depth (controllable by encoder)
-    lfo.setWaveform(Waveform::Triangle);  // Smooth pitch transitions
-    envelope.setAttack(0.01f);
-    envelope.setRelease(0.5f);
-    delay.setDryWet(0.3f);
-    delay.setFeedback(0.55f);    // Spacey dub echoes
-    reverb.setDryWet(0.4f);      // Wet for atmosphere
+    // Volume 0.7, 440 Hz, no LFO pitch modulation, pitch envelope UP
+    // (classic dub siren) come from the EngineParameters defaults.
+    controlParams.oscWaveform = Waveform::Square;  // Square for classic siren sound
+    controlParams.lfo.frequency = 0.35f;     // Slow swell - rises and falls over ~3 seconds
+    controlParams.lfo.depth = 0.5f;          // Filter modulation depth (controllable by encoder)
+    controlParams.lfo.waveform = Waveform::Triangle;  // Smooth pitch transitions
+    controlParams.envelope.attackTime = 0.01f;
+    controlParams.envelope.releaseTime = 0.5f;
+    controlParams.delay.dryWet = 0.3f;
+    controlParams.delay.feedback = 0.55f;    // Spacey dub echoes
+    controlParams.reverb.wet = 0.4f;         // Wet for atmosphere
+
+    envelope.prepareParameters(controlParams.envelope);
+    lfo.prepareParameters(controlParams.lfo);
+    delay.prepareParameters(controlParams.delay);
+    reverb.prepareParameters(controlParams.reverb);
+
+    // No audio thread yet: install directly and seed the snapshot buffer
+    activeParams = controlParams;
+    applyParameters(activeParams);
+    std::lock_guard<std::mutex> lock(controlMutex);
+    publishParameters();
+}
+
+void AudioEngine::publishParameters() {
+    paramSnapshots.writeBuffer() = controlParams;
+    paramSnapshots.publish();
+}
+
+void AudioEngine::applyParameters(const EngineParameters& p) {
+    oscillator.setWaveform(p.oscWaveform);
+    envelope.setParameters(p.envelope);
+    lfo.setParameters(p.lfo);
+    filter.setCutoff(p.filterCutoff);
+    filter.setResonance(p.filterResonance);
+    delay.setParameters(p.delay);
+    reverb.setParameters(p.reverb);
+}
+
+// Blend the continuous parameters of two snapshots. Derived coefficients
+// are interpolated directly (no trig on the audio thread); for the reverb
+// damping biquads this stays stable, since the set of stable coefficient
+// pairs (a1, a2) is convex. Discrete settings switch to `to` at once.
+static void blendParameters(const EngineParameters& from, const EngineParameters& to,
+                            float t, EngineParameters& out) {
+    out = to;
+
+    out.volume = lerp(from.volume, to.volume, t);
+    out.baseFrequency = lerp(from.baseFrequency, to.baseFrequency, t);
+    out.lfoPitchDepth = lerp(from.lfoPitchDepth, to.lfoPitchDepth, t);
+    out.filterCutoff = lerp(from.filterCutoff, to.filterCutoff, t);
+    out.filterResonance = lerp(from.filterResonance, to.filterResonance, t);
+
+    out.envelope.attackCoeff = lerp(from.envelope.attackCoeff, to.envelope.attackCoeff, t);
+    out.envelope.releaseCoeff = lerp(from.envelope.releaseCoeff, to.envelope.releaseCoeff, t);
+
+    out.lfo.depth = lerp(from.lfo.depth, to.lfo.depth, t);
+    out.lfo.phaseIncrement = lerp(from.lfo.phaseIncrement, to.lfo.phaseIncrement, t);
+
+    out.delay.feedback = lerp(from.delay.feedback, to.delay.feedback, t);
+    out.delay.dryWet = lerp(from.delay.dryWet, to.delay.dryWet, t);
+    out.delay.modDepth = lerp(from.delay.modDepth, to.delay.modDepth, t);
+    out.delay.modRate = lerp(from.delay.modRate, to.delay.modRate, t);
+    out.delay.tapeSaturation = lerp(from.delay.tapeSaturation, to.delay.tapeSaturation, t);
+    out.delay.targetDelaySamples = lerp(from.delay.targetDelaySamples, to.delay.targetDelaySamples, t);
+    out.delay.hpCoeff = lerp(from.delay.hpCoeff, to.delay.hpCoeff, t);
+    out.delay.lpCoeff = lerp(from.delay.lpCoeff, to.delay.lpCoeff, t);
+
+    out.reverb.wet = lerp(from.reverb.wet, to.reverb.wet, t);
+    out.reverb.width = lerp(from.reverb.width, to.reverb.width, t);
+    for (int i = 0; i < ReverbEffect::NUM_SPRINGS; ++i) {
+        out.reverb.springFeedback[i] = lerp(from.reverb.springFeedback[i], to.reverb.springFeedback[i], t);
+    }
+    const ReverbEffect::BiquadCoeffs& a = from.reverb.dampingCoeffs;
+    const ReverbEffect::BiquadCoeffs& b = to.reverb.dampingCoeffs;
+    out.reverb.dampingCoeffs = {lerp(a.b0, b.b0, t), lerp(a.b1, b.b1, t), lerp(a.b2, b.b2, t),
+                                lerp(a.a1, b.a1, t), lerp(a.a2, b.a2, t)};
+}
+
+// Visit every morph lane of a parameter set, in lane order
+template<typename Params, typename Fn>
+static void forEachMorphLane(Params& p, Fn&& fn) {
+    fn(p.baseFrequency);
+    fn(p.lfoPitchDepth);
+    fn(p.lfo.frequency);
+    fn(p.lfo.phaseIncrement);
+    fn(p.lfo.depth);
+    fn(p.envelope.releaseTime);
+    fn(p.envelope.releaseCoeff);
+    fn(p.delay.delayTime);
+    fn(p.delay.targetDelaySamples);
+    fn(p.delay.feedback);
+    fn(p.reverb.size);
+    fn(p.reverb.wet);
+    for (int i = 0; i < ReverbEffect::NUM_SPRINGS; ++i) {
+        fn(p.reverb.springFeedback[i]);
+    }
+    // Damping biquad, in coefficient space (stable, see blendParameters)
+    fn(p.reverb.dampingCoeffs.b0);
+    fn(p.reverb.dampingCoeffs.b1);
+    fn(p.reverb.dampingCoeffs.b2);
+    fn(p.reverb.dampingCoeffs.a1);
+    fn(p.reverb.dampingCoeffs.a2);
+}
+
+static void evaluateMorph(const MorphParameters& morph, float position, EngineParameters& out) {
+    int lane = 0;
+    forEachMorphLane(out, [&](float& value) {
+        value = morph.base[lane] + position * morph.delta[lane];
+        ++lane;
+    });
+}
+
+void AudioEngine::updateActiveParameters(int numFrames) {
+    bool fresh = paramSnapshots.acquire();
+    const EngineParameters& latest = paramSnapshots.current();
+
+    if (fresh && latest.crossfadeSerial != activeParams.crossfadeSerial) {
+        // New preset: fade from whatever is playing now (possibly mid-fade)
+        crossfadeFrom = activeParams;
+        crossfadeRemaining = crossfadeLength;
+    }
+
+    bool morphing = latest.morph.enabled;
+    if (morphing) {
+        if (!activeParams.morph.enabled) {
+            // Morph takes over: fade from the current values into it
+            morphPosition.setImmediate(latest.morph.position);
+            crossfadeFrom = activeParams;
+            crossfadeRemaining = crossfadeLength;
+        } else {
+            morphPosition.setTarget(latest.morph.position);
+        }
+    } else if (activeParams.morph.enabled) {
+        // Morph released: fade from the morphed values back to the snapshot
+        crossfadeFrom = activeParams;
+        crossfadeRemaining = crossfadeLength;
+    }
+
+    if (!fresh && crossfadeRemaining == 0 && !(morphing && morphPosition.isSmoothing())) {
+        return;  // Nothing changed since the last block
+    }
+
+    // Target for this block: the latest snapshot, morph evaluated
+    const EngineParameters* target = &latest;
+    if (morphing) {
+        morphTarget = latest;
+        evaluateMorph(latest.morph, morphPosition.getNext(), morphTarget);
+        target = &morphTarget;
+    }
+
+    if (crossfadeRemaining > 0) {
+        crossfadeRemaining = std::max(0, crossfadeRemaining - numFrames);
+        if (crossfadeRemaining == 0) {
+            activeParams = *target;
+        } else {
+            float t = 1.0f - static_cast<float>(crossfadeRemaining) / static_cast<float>(crossfadeLength);
+            blendParameters(crossfadeFrom, *target, t, activeParams);
+        }
+    } else {
+        activeParams = *target;
+    }
+    applyParameters(activeParams);
+}
+
+void AudioEngine::process(float* output, int numFrames, const CaptureBlock* input) {
+    captureInput = input;
+    process(output, numFrames);
+    captureInput = nullptr;
 }
 
 void AudioEngine::process(float* output, int numFrames) {
+    // Pick up the latest parameter snapshot (wait-free, once per block)
+    updateActiveParameters(numFrames);
+    const EngineParameters& params = activeParams;
+
+    // Drain trigger/release events queued since the previous block
+    int numEvents = collectNoteEvents(numFrames);
+
     // Check if in MP3 playback mode
     if (audioMode.get() == AudioMode::MP3Playback && mp3Player) {
+        // Keep envelope state in sync so no note is left hanging on return;
+        // one-shots do not play over MP3 mode
+        for (int e = 0; e < numEvents; ++e) {
+            if (blockEvents[e].type != NoteEvent::Type::Sample) {
+                applyNoteEvent(blockEvents[e], blockEventOffsets[e]);
+            }
+        }
+        sampler.stopAll();
         mp3Player->fillBuffer(output, numFrames);
         return;
     }
 
     // Normal synthesis mode
+    frequencySmooth.setTarget(params.baseFrequency);
+    volumeSmooth.setTarget(params.volume);
+
+    // Render in segments split at event offsets so each trigger/release
+    // lands on its exact sample (sample voices start at their offset in
+    // the chain instead)
+    int segmentStart = 0;
+    for (int e = 0; e < numEvents; ++e) {
+        int offset = blockEventOffsets[e];
+        if (blockEvents[e].type == NoteEvent::Type::Sample) {
+            applyNoteEvent(blockEvents[e], offset);
+            continue;
+        }
+        if (offset > segmentStart) {
+            renderSynth(params, segmentStart, offset - segmentStart);
+            segmentStart = offset;
+        }
+        applyNoteEvent(blockEvents[e], offset);
+    }
+    if (segmentStart < numFrames) {
+        renderSynth(params, segmentStart, numFrames - segmentStart);
+    }
+
+    // Sample varispeed follows the oscillator's pitch modulation
+    samplePitchSmooth.setTarget(params.samplePitch);
+    samplePitchSmooth.process(samplePitchBuffer.data(), numFrames);
+    for (int i = 0; i < numFrames; ++i) {
+        samplePitchBuffer[i] *= pitchModBuffer[i];
+    }
+
+    // Envelope -> [filter] -> delay/reverb -> DC blocker, in place
+    if (params.effectOrder == EffectOrder::ReverbThenDelay) {
+        runEffectChain(reverbFirstChain, params, numFrames);
+    } else {
+        runEffectChain(delayFirstChain, params, numFrames);
+    }
+
+    // Apply volume (click-free ramp) and convert to stereo interleaved
+    volumeSmooth.process(volumeBuffer.data(), numFrames);
+    for (int i = 0; i < numFrames; ++i) {
+        float sample = clamp(oscBuffer[i] * volumeBuffer[i], -1.0f, 1.0f);
+        output[i * 2] = sample;      // Left
+        output[i * 2 + 1] = sample;  // Right
+    }
+}
+
+template<typename Chain>
+void AudioEngine::runEffectChain(Chain& chain, const EngineParameters& params, int numFrames) {
+    chain.template get<FilterStage>().enabled = params.filterEnabled;
+    chain.template get<DelayStage>().enabled = params.delayEnabled;
+    chain.template get<ReverbStage>().enabled = params.reverbEnabled;
+    chain.template get<ExternalInputStage>().input = captureInput;
+    chain.template get<ExternalInputStage>().gain = params.inputGain;
+    chain.template get<SamplerStage>().gain = params.sampleGain;
+    chain.template get<SamplerStage>().rate = samplePitchBuffer.data();
+    chain.process(oscBuffer.data(), numFrames);
+}
+
+void AudioEngine::renderSynth(const EngineParameters& params, int start, int count) {
     // Get pitch envelope mode
-    PitchEnvelopeMode pitchMode = pitchEnvMode.get();
-    float baseFreq = baseFrequency.get();
-    float pitchDepth = lfoPitchDepth.get();
+    PitchEnvelopeMode pitchMode = params.pitchEnvMode;
+    float pitchDepth = params.lfoPitchDepth;
+
+    // Smoothed base frequency (encoder steps glide instead of jumping)
+    frequencySmooth.process(freqBuffer.data() + start, count);
 
     // Generate envelope first (we need it for pitch envelope calculation)
-    envelope.generate(envBuffer.data(), numFrames);
+    envelope.generate(envBuffer.data() + start, count);
 
     // Generate LFO modulation (needed for pitch modulation)
-    lfo.generate(lfoBuffer.data(), numFrames);
+    lfo.generate(lfoBuffer.data() + start, count);
 
     // Generate oscillator with pitch envelope and LFO pitch modulation
-    for (int i = 0; i < numFrames; ++i) {
+    for (int i = start; i < start + count; ++i) {
+        float baseFreq = freqBuffer[i];
         float targetFreq = baseFreq;
         
         // Apply pitch envelope during release phase
@@ -106,62 +360,110 @@ void AudioEngine::process(float* output, int numFrames) {
             targetFreq *= pitchMult;
         }
 
-        // Smooth frequency changes to avoid clicks
-        frequencySmooth.setTarget(targetFreq);
-        currentFrequency = frequencySmooth.getNext();
+        // Only the base frequency is smoothed (block ramp above); envelope and
+        // LFO modulation apply as-is, the oscillator phase stays continuous
+        pitchModBuffer[i] = targetFreq / baseFreq;
+        currentFrequency = targetFreq;
         oscillator.setFrequency(currentFrequency);
         oscBuffer[i] = oscillator.generateSample();
     }
+}
 
-    // Copy oscillator output to working buffer
-    std::copy(oscBuffer.begin(), oscBuffer.begin() + numFrames, processBuffer.begin());
+// ============================================================================
+// Note Events
+// ============================================================================
 
-    // Apply envelope
-    for (int i = 0; i < numFrames; ++i) {
-        if (envBuffer[i] < 0.001f) {
-            processBuffer[i] = 0.0f;
-        } else {
-            processBuffer[i] *= envBuffer[i];
-        }
+void AudioEngine::trigger() {
+    trigger(monotonicNanos());
+}
+
+void AudioEngine::trigger(int64_t timestampNs) {
+    pushNoteEvent(NoteEvent::Type::Trigger, timestampNs);
+}
+
+void AudioEngine::release() {
+    release(monotonicNanos());
+}
+
+void AudioEngine::release(int64_t timestampNs) {
+    pushNoteEvent(NoteEvent::Type::Release, timestampNs);
+}
+
+void AudioEngine::triggerSample(int index) {
+    triggerSample(index, monotonicNanos());
+}
+
+void AudioEngine::triggerSample(int index, int64_t timestampNs) {
+    if (index >= 0 && index < sampler.getSampleCount()) {
+        pushNoteEvent(NoteEvent::Type::Sample, timestampNs, index);
     }
-    
-    // Apply delay
-    delay.process(processBuffer.data(), delayBuffer.data(), numFrames);
-    std::copy(delayBuffer.begin(), delayBuffer.begin() + numFrames, processBuffer.begin());
-    
-    // Apply reverb
-    reverb.process(processBuffer.data(), delayBuffer.data(), numFrames);
-    std::copy(delayBuffer.begin(), delayBuffer.begin() + numFrames, processBuffer.begin());
-    
-    // Apply DC blocking
-    dcBlocker.process(processBuffer.data(), processBuffer.data(), numFrames);
-    
-    // Apply volume and convert to stereo interleaved
-    float vol = volume.get();
-    for (int i = 0; i < numFrames; ++i) {
-        float sample = clamp(processBuffer[i] * vol, -1.0f, 1.0f);
-        output[i * 2] = sample;      // Left
-        output[i * 2 + 1] = sample;  // Right
+}
+
+bool AudioEngine::loadSamples(const std::string& path) {
+    return sampler.loadBank(path);
+}
+
+void AudioEngine::setDelayLineStorage(LineStorage storage) {
+    delay.setLineStorage(storage);
+    reverb.setLineStorage(storage);
+}
+
+void AudioEngine::pushNoteEvent(NoteEvent::Type type, int64_t timestampNs, int sample) {
+    std::lock_guard<std::mutex> lock(eventProducerMutex);
+    if (!noteEvents.push({type, timestampNs, sample})) {
+        std::cerr << "[Engine] Note event queue full, event dropped" << std::endl;
     }
 }
 
-void AudioEngine::trigger() {
-    std::lock_guard<std::mutex> lock(triggerMutex);
-    oscillator.resetPhase();
-    envelope.trigger();
-    inReleasePhase = false;  // We're in attack/sustain phase
+int AudioEngine::collectNoteEvents(int numFrames) {
+    // Events that arrived during the previous block are replayed at the same
+    // relative position in this one: a constant one-block latency instead of
+    // a jitter of up to one block depending on when the button was pressed.
+    int64_t blockStartNs = monotonicNanos();
+    int64_t windowStartNs = lastBlockStartNs;
+    lastBlockStartNs = blockStartNs;
+
+    int numEvents = 0;
+    int lastOffset = 0;
+    NoteEvent event;
+    while (numEvents < MAX_EVENTS_PER_BLOCK && noteEvents.pop(event)) {
+        int64_t deltaNs = event.timestampNs - windowStartNs;
+        int64_t deltaFrames = (deltaNs > 0) ? deltaNs * sampleRate / 1000000000LL : 0;
+
+        // Keep events ordered and inside the block
+        int offset = static_cast<int>(std::min<int64_t>(deltaFrames, numFrames - 1));
+        offset = std::max(lastOffset, offset);
+        lastOffset = offset;
+
+        blockEvents[numEvents] = event;
+        blockEventOffsets[numEvents] = offset;
+        ++numEvents;
+    }
+    return numEvents;
 }
 
-void AudioEngine::release() {
-    std::lock_guard<std::mutex> lock(triggerMutex);
-    // Capture envelope level at start of release for pitch envelope
-    pitchEnvStartLevel = envelope.getCurrentValue();
-    inReleasePhase = true;  // Start release phase (enables pitch envelope)
-    envelope.release();
+void AudioEngine::applyNoteEvent(const NoteEvent& event, int offset) {
+    if (event.type == NoteEvent::Type::Sample) {
+        float stretch = activeParams.sampleStretch;
+        if (activeParams.sampleStretchToDelay) {
+            stretch = activeParams.delay.delayTime * static_cast<float>(sampleRate)
+                    / static_cast<float>(sampler.getSampleFrames(event.sample));
+        }
+        sampler.start(event.sample, offset, 1.0f, stretch);
+    } else if (event.type == NoteEvent::Type::Trigger) {
+        oscillator.resetPhase();
+        envelope.trigger();
+        inReleasePhase = false;  // We're in attack/sustain phase
+    } else {
+        // Capture envelope level at start of release for pitch envelope
+        pitchEnvStartLevel = envelope.getCurrentValue();
+        inReleasePhase = true;  // Start release phase (enables pitch envelope)
+        envelope.release();
+    }
 }
 
 const char* AudioEngine::cyclePitchEnvelope() {
-    PitchEnvelopeMode current = pitchEnvMode.get();
+    PitchEnvelopeMode current = getPitchEnvelopeMode();
     PitchEnvelopeMode next;
     
     switch (current) {
@@ -177,7 +479,7 @@ const char* AudioEngine::cyclePitchEnvelope() {
             break;
     }
     
-    pitchEnvMode.set(next);
+    setPitchEnvelopeMode(next);
     
     switch (next) {
         case PitchEnvelopeMode::None: return "none";
@@ -192,15 +494,21 @@ const char* AudioEngine::cyclePitchEnvelope() {
 // ============================================================================
 
 void AudioEngine::setVolume(float vol) {
-    volume.set(clamp(vol, 0.0f, 1.0f));
+    updateParameters([&](EngineParameters& p) {
+        p.volume = clamp(vol, 0.0f, 1.0f);
+    });
 }
 
 void AudioEngine::setFrequency(float freq) {
-    baseFrequency.set(clamp(freq, 20.0f, 20000.0f));
+    updateParameters([&](EngineParameters& p) {
+        p.baseFrequency = clamp(freq, 20.0f, 20000.0f);
+    });
 }
 
 void AudioEngine::setWaveform(Waveform wf) {
-    oscillator.setWaveform(wf);
+    updateParameters([&](EngineParameters& p) {
+        p.oscWaveform = wf;
+    });
 }
 
 void AudioEngine::setWaveform(int index) {
@@ -208,27 +516,43 @@ void AudioEngine::setWaveform(int index) {
 }
 
 void AudioEngine::setAttackTime(float seconds) {
-    envelope.setAttack(seconds);
+    updateParameters([&](EngineParameters& p) {
+        p.envelope.attackTime = seconds;
+        envelope.prepareParameters(p.envelope);
+    });
 }
 
 void AudioEngine::setReleaseTime(float seconds) {
-    envelope.setRelease(seconds);
+    updateParameters([&](EngineParameters& p) {
+        p.envelope.releaseTime = seconds;
+        envelope.prepareParameters(p.envelope);
+    });
 }
 
 void AudioEngine::setLfoRate(float rate) {
-    lfo.setFrequency(rate);
+    updateParameters([&](EngineParameters& p) {
+        p.lfo.frequency = rate;
+        lfo.prepareParameters(p.lfo);
+    });
 }
 
 void AudioEngine::setLfoDepth(float depth) {
-    lfo.setDepth(depth);
+    updateParameters([&](EngineParameters& p) {
+        p.lfo.depth = depth;
+        lfo.prepareParameters(p.lfo);
+    });
 }
 
 void AudioEngine::setLfoPitchDepth(float depth) {
-    lfoPitchDepth.set(clamp(depth, 0.0f, 1.0f));
+    updateParameters([&](EngineParameters& p) {
+        p.lfoPitchDepth = clamp(depth, 0.0f, 1.0f);
+    });
 }
 
 void AudioEngine::setLfoWaveform(Waveform wf) {
-    lfo.setWaveform(wf);
+    updateParameters([&](EngineParameters& p) {
+        p.lfo.waveform = wf;
+    });
 }
 
 void AudioEngine::setLfoWaveform(int index) {
@@ -236,31 +560,240 @@ void AudioEngine::setLfoWaveform(int index) {
 }
 
 void AudioEngine::setDelayTime(float seconds) {
-    delay.setDelayTime(seconds);
+    updateParameters([&](EngineParameters& p) {
+        p.delay.delayTime = seconds;
+        delay.prepareParameters(p.delay);
+    });
 }
 
 void AudioEngine::setDelayFeedback(float feedback) {
-    delay.setFeedback(feedback);
+    updateParameters([&](EngineParameters& p) {
+        p.delay.feedback = feedback;
+        delay.prepareParameters(p.delay);
+    });
 }
 
 void AudioEngine::setDelayMix(float mix) {
-    delay.setDryWet(mix);
+    updateParameters([&](EngineParameters& p) {
+        p.delay.dryWet = mix;
+        delay.prepareParameters(p.delay);
+    });
 }
 
 void AudioEngine::setReverbSize(float size) {
-    reverb.setSize(size);
+    updateParameters([&](EngineParameters& p) {
+        p.reverb.size = size;
+        reverb.prepareParameters(p.reverb);
+    });
 }
 
 void AudioEngine::setReverbMix(float mix) {
-    reverb.setDryWet(mix);
+    updateParameters([&](EngineParameters& p) {
+        p.reverb.wet = mix;
+        reverb.prepareParameters(p.reverb);
+    });
 }
 
 void AudioEngine::setReverbDamping(float damping) {
-    reverb.setDamping(damping);
+    updateParameters([&](EngineParameters& p) {
+        p.reverb.damping = damping;
+        reverb.prepareParameters(p.reverb);
+    });
+}
+
+void AudioEngine::setFilterCutoff(float freq) {
+    updateParameters([&](EngineParameters& p) {
+        p.filterCutoff = clamp(freq, 20.0f, 20000.0f);
+    });
+}
+
+void AudioEngine::setFilterResonance(float res) {
+    updateParameters([&](EngineParameters& p) {
+        p.filterResonance = clamp(res, 0.1f, 20.0f);
+    });
+}
+
+void AudioEngine::setEffectOrder(EffectOrder order) {
+    updateParameters([&](EngineParameters& p) {
+        p.effectOrder = order;
+    });
+}
+
+void AudioEngine::setFilterEnabled(bool enabled) {
+    updateParameters([&](EngineParameters& p) {
+        p.filterEnabled = enabled;
+    });
+}
+
+void AudioEngine::setDelayEnabled(bool enabled) {
+    updateParameters([&](EngineParameters& p) {
+        p.delayEnabled = enabled;
+    });
+}
+
+void AudioEngine::setReverbEnabled(bool enabled) {
+    updateParameters([&](EngineParameters& p) {
+        p.reverbEnabled = enabled;
+    });
+}
+
+void AudioEngine::setInputGain(float gain) {
+    updateParameters([&](EngineParameters& p) {
+        p.inputGain = clamp(gain, 0.0f, 2.0f);
+    });
+}
+
+void AudioEngine::setSampleGain(float gain) {
+    updateParameters([&](EngineParameters& p) {
+        p.sampleGain = clamp(gain, 0.0f, 2.0f);
+    });
+}
+
+void AudioEngine::setSampleStretch(float factor) {
+    updateParameters([&](EngineParameters& p) {
+        p.sampleStretch = clamp(factor, Sampler::MIN_STRETCH, Sampler::MAX_STRETCH);
+    });
+}
+
+void AudioEngine::setSampleStretchToDelay(bool enabled) {
+    updateParameters([&](EngineParameters& p) {
+        p.sampleStretchToDelay = enabled;
+    });
+}
+
+void AudioEngine::setSamplePitch(float semitones) {
+    updateParameters([&](EngineParameters& p) {
+        p.samplePitch = std::exp2(clamp(semitones, -24.0f, 24.0f) / 12.0f);
+    });
 }
 
 void AudioEngine::setPitchEnvelopeMode(PitchEnvelopeMode mode) {
-    pitchEnvMode.set(mode);
+    updateParameters([&](EngineParameters& p) {
+        p.pitchEnvMode = mode;
+    });
+}
+
+void AudioEngine::loadPreset(const Preset& preset, EngineParameters& p) const {
+    p.baseFrequency = clamp(preset.baseFrequency, 20.0f, 20000.0f);
+    p.oscWaveform = static_cast<Waveform>(preset.oscWaveform % 4);
+
+    p.envelope.releaseTime = preset.releaseTime;
+    envelope.prepareParameters(p.envelope);
+
+    if (preset.flags & Preset::HAS_LFO_RATE) {
+        p.lfo.frequency = preset.lfoRate;
+        p.lfo.waveform = static_cast<Waveform>(preset.lfoWaveform % 4);
+    }
+    if (preset.flags & Preset::HAS_LFO_DEPTH) {
+        p.lfo.depth = preset.lfoDepth;
+    }
+    if (preset.flags & Preset::HAS_LFO_PITCH_DEPTH) {
+        p.lfoPitchDepth = clamp(preset.lfoPitchDepth, 0.0f, 1.0f);
+    }
+    lfo.prepareParameters(p.lfo);
+
+    p.delay.delayTime = preset.delayTime;
+    p.delay.feedback = preset.delayFeedback;
+    delay.prepareParameters(p.delay);
+
+    p.reverb.size = preset.reverbSize;
+    p.reverb.wet = preset.reverbMix;
+    reverb.prepareParameters(p.reverb);
+}
+
+void AudioEngine::applyPreset(const Preset& preset) {
+    updateParameters([&](EngineParameters& p) {
+        loadPreset(preset, p);
+        ++p.crossfadeSerial;
+    });
+}
+
+void AudioEngine::setMorphEndpoints(const Preset& a, const Preset& b) {
+    updateParameters([&](EngineParameters& p) {
+        EngineParameters pa = p;
+        EngineParameters pb = p;
+        loadPreset(a, pa);
+        loadPreset(b, pb);
+
+        std::array<float, MorphParameters::NUM_LANES> lanesB;
+        int lane = 0;
+        forEachMorphLane(pb, [&](float value) { lanesB[lane++] = value; });
+        lane = 0;
+        forEachMorphLane(pa, [&](float value) {
+            p.morph.base[lane] = value;
+            p.morph.delta[lane] = lanesB[lane] - value;
+            ++lane;
+        });
+
+        p.morph.enabled = false;
+        p.morph.position = 0.0f;
+    });
+}
+
+void AudioEngine::setMorphPosition(float position) {
+    updateParameters([&](EngineParameters& p) {
+        p.morph.position = clamp(position, 0.0f, 1.0f);
+        p.morph.enabled = true;
+    });
+}
+
+AudioEngine::MorphLanes AudioEngine::readMorphLanes(const EngineParameters& p) {
+    MorphLanes lanes;
+    int lane = 0;
+    forEachMorphLane(p, [&](float value) { lanes[lane++] = value; });
+    return lanes;
+}
+
+void AudioEngine::rebaseMorph(const MorphLanes& before) {
+    // Shift every lane the update changed so base + position * delta lands
+    // on its new value; delta is kept, so turning the morph further still
+    // travels the same distance towards B
+    MorphParameters& morph = controlParams.morph;
+    int lane = 0;
+    forEachMorphLane(controlParams, [&](float value) {
+        if (value != before[lane]) {
+            morph.base[lane] = value - morph.position * morph.delta[lane];
+        }
+        ++lane;
+    });
+}
+
+void AudioEngine::clearMorph() {
+    updateParameters([&](EngineParameters& p) {
+        p.morph.enabled = false;
+    });
+}
+
+void AudioEngine::beginParameterBatch() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    ++batchDepth;
+}
+
+void AudioEngine::endParameterBatch() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (batchDepth > 0 && --batchDepth == 0) {
+        publishParameters();
+    }
+}
+
+float AudioEngine::getVolume() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return controlParams.volume;
+}
+
+float AudioEngine::getFrequency() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return controlParams.baseFrequency;
+}
+
+float AudioEngine::getSamplePitch() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return 12.0f * std::log2(controlParams.samplePitch);
+}
+
+PitchEnvelopeMode AudioEngine::getPitchEnvelopeMode() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return controlParams.pitchEnvMode;
 }
 
 // ============================================================================
@@ -282,6 +815,29 @@ bool AudioEngine::enableMP3Mode(const std::string& directory) {
     return false;
 }
 
+void AudioEngine::setMP3SampleStorage(AudioFilePlayer::SampleStorage storage) {
+    // process() only touches the player in MP3 mode
+    if (isMP3Mode()) {
+        std::cerr << "[MP3] Sample storage can only change outside MP3 mode" << std::endl;
+        return;
+    }
+
+    if (!mp3Player || mp3Player->getSampleStorage() != storage) {
+        auto player = std::make_unique<AudioFilePlayer>(storage);
+        if (mp3Player) {
+            player->setChained(mp3Player->isChained(), mp3Player->getChainCrossfade());
+        }
+        mp3Player = std::move(player);
+    }
+}
+
+void AudioEngine::setMP3Chain(bool chained, float crossfadeSeconds) {
+    if (!mp3Player) {
+        mp3Player = std::make_unique<AudioFilePlayer>();
+    }
+    mp3Player->setChained(chained, crossfadeSeconds);
+}
+
 void AudioEngine::disableMP3Mode() {
     audioMode.set(AudioMode::Synthesis);
     if (mp3Player) {
@@ -297,6 +853,20 @@ void AudioEngine::startMP3Playback() {
     }
 }
 
+void AudioEngine::startMP3Cue(int cue) {
+    if (mp3Player && audioMode.get() == AudioMode::MP3Playback) {
+        mp3Player->playCue(cue);
+        std::cout << "Playing MP3: " << mp3Player->getCurrentFileName() << " from cue " << (cue + 1) << std::endl;
+    }
+}
+
+int AudioEngine::getMP3CueCount() const {
+    if (mp3Player) {
+        return mp3Player->getCueCount();
+    }
+    return 0;
+}
+
 void AudioEngine::stopMP3Playback() {
     if (mp3Player) {
         mp3Player->stop();
@@ -323,6 +893,13 @@ int AudioEngine::getMP3FileCount() const {
     return 0;
 }
 
+bool AudioEngine::isMP3Loading() const {
+    if (mp3Player) {
+        return mp3Player->isLoading();
+    }
+    return false;
+}
+
 std::string AudioEngine::getCurrentMP3FileName() const {
     if (mp3Player) {
         return mp3Player->getCurrentFileName();
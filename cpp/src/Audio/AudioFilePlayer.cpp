@@ -1,8 +1,15 @@
 #include "Audio/AudioFilePlayer.h"
+#include "DSP/Resampler.h"
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
 #include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <numeric>
+#include <chrono>
+#include <fstream>
+#include <sys/mman.h>
 
 #define MINIMP3_IMPLEMENTATION
 #define MINIMP3_FLOAT_OUTPUT
@@ -24,25 +31,328 @@ const AudioFilePlayer::Color AudioFilePlayer::FILE_COLORS[] = {
 
 const int AudioFilePlayer::NUM_COLORS = sizeof(FILE_COLORS) / sizeof(FILE_COLORS[0]);
 
-AudioFilePlayer::AudioFilePlayer() {
+namespace {
+
+// Read through stdio rather than mp3dec_ex_open's mmap: with mlockall() in
+// force a mapping would pin the whole compressed file
+size_t readFile(void* buf, size_t size, void* userData) {
+    return std::fread(buf, 1, size, static_cast<FILE*>(userData));
+}
+
+int seekFile(uint64_t position, void* userData) {
+    return fseeko(static_cast<FILE*>(userData), static_cast<off_t>(position), SEEK_SET);
+}
+
+} // anonymous namespace
+
+// Byte offset and first sample of every frame of an MP3 file, as minimp3
+// builds it for mp3dec_ex_seek(); shared by every library listing the file
+struct MP3FrameIndex {
+    std::vector<mp3dec_frame_t> frames;
+};
+
+struct AudioFilePlayer::DecodeStream {
+    static constexpr size_t CHUNK_FRAMES = 1152;  // One MPEG-1 layer III frame
+    static constexpr size_t MAX_UPSAMPLE = 6;     // 8kHz (lowest MP3 rate) to 48kHz
+    static constexpr size_t PENDING_FRAMES =      // process() plus flush() bound
+        (CHUNK_FRAMES + 3 * DubSiren::PolyphaseResampler::TAPS) * MAX_UPSAMPLE + 2;
+
+    mp3dec_ex_t dec;
+    mp3dec_io_t io;
+    FILE* file = nullptr;
+    bool decoderOpen = false;
+    bool indexLent = false;  // dec.index points into an MP3FrameIndex
+    int channels = 2;
+    bool eof = true;
+    uint64_t remaining = UINT64_MAX;  // Frames until the stream ends early (a loop end)
+    bool chainable = false;           // Runs to the end of the file
+    int fileIndex = -1;
+    uint32_t serial = 0;              // Published as
+    DubSiren::PolyphaseResampler resampler{2};
+
+    // Sample bank source (instead of the MP3 decoder)
+    const void* bankData = nullptr;
+    uint64_t bankFrames = 0;
+    uint64_t bankPos = 0;
+    uint16_t bankFormat = DubSiren::SampleBank::FORMAT_S16;
+
+    float decoded[CHUNK_FRAMES * 2];
+    float pending[PENDING_FRAMES * 2];  // Resampled, waiting for ring space
+    size_t pendingFrames = 0;
+    size_t pendingPos = 0;
+
+    std::shared_ptr<const SampleLibrary> library;  // Files being streamed
+    DubSiren::SampleConverter converter{DubSiren::SampleFormat::S16};  // Int16 storage
+
+    ~DecodeStream() { close(); }
+
+    // Streaming 16-bit bank PCM: already dithered when it was packed
+    bool isQuantized() const { return bankData && bankFormat == DubSiren::SampleBank::FORMAT_S16; }
+
+    bool openMP3(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+
+        io.read = readFile;
+        io.read_data = file;
+        io.seek = seekFile;
+        io.seek_data = file;
+
+        // No full-file scan for the length: seeks use the index built at load
+        decoderOpen = true;
+        if (mp3dec_ex_open_cb(&dec, &io, MP3D_SEEK_TO_SAMPLE | MP3D_DO_NOT_SCAN) != 0 ||
+            dec.info.hz <= 0 || dec.info.channels < 1 || dec.info.channels > 2) {
+            close();
+            return false;
+        }
+
+        channels = dec.info.channels;
+        eof = false;
+        remaining = UINT64_MAX;
+        pendingFrames = pendingPos = 0;
+        return true;
+    }
+
+    void openBank(const DubSiren::SampleBank& bank, const DubSiren::SampleBankEntry& entry) {
+        close();
+        bankData = bank.data(entry);
+        bankFrames = entry.frames;
+        bankPos = 0;
+        bankFormat = bank.getFormat();
+        eof = (bankFrames == 0);
+        remaining = UINT64_MAX;
+
+        // Read ahead from the start; nothing in the mapping is page-locked
+        posix_madvise(const_cast<void*>(bankData), bankFrames * bank.bytesPerFrame(), POSIX_MADV_SEQUENTIAL);
+    }
+
+    // Move to an output frame before anything is decoded
+    bool seek(uint64_t frame, const MP3FrameIndex* index) {
+        if (bankData) {
+            bankPos = std::min(frame, bankFrames);
+            eof = (bankPos == bankFrames);
+            return true;
+        }
+        if (frame == 0) {
+            return true;
+        }
+
+        // Lend minimp3 the prebuilt index rather than have it scan the file:
+        // once an index is built it only reads it, and close() takes it back
+        if (index && !index->frames.empty() && !dec.indexes_built) {
+            dec.index.frames = const_cast<mp3dec_frame_t*>(index->frames.data());
+            dec.index.num_frames = dec.index.capacity = index->frames.size();
+            dec.indexes_built = 1;
+            indexLent = true;
+        }
+
+        uint64_t sample = frame * static_cast<uint64_t>(dec.info.hz) / OUTPUT_RATE;
+        if (mp3dec_ex_seek(&dec, sample * channels) != 0) {
+            eof = true;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (indexLent) {
+            dec.index.frames = nullptr;
+            indexLent = false;
+        }
+        if (decoderOpen) {
+            mp3dec_ex_close(&dec);
+            decoderOpen = false;
+        }
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        bankData = nullptr;
+        eof = true;
+        chainable = false;
+        pendingFrames = pendingPos = 0;
+    }
+
+    // Decode and resample the next chunk into pending
+    size_t decodeChunk() {
+        size_t frames = bankData ? copyBankChunk() : decodeMP3Chunk();
+        if (frames >= remaining) {
+            pendingFrames = static_cast<size_t>(remaining);
+            eof = true;
+        }
+        remaining -= pendingFrames;
+        return pendingFrames;
+    }
+
+    size_t decodeMP3Chunk() {
+        size_t frames = mp3dec_ex_read(&dec, decoded, CHUNK_FRAMES * channels) / channels;
+        if (frames < CHUNK_FRAMES) {
+            if (dec.last_error) {
+                std::cerr << "[MP3] Decode error " << dec.last_error << ", ending playback early" << std::endl;
+            }
+            eof = true;
+        }
+
+        // Mono is spread to stereo before resampling
+        if (channels == 1) {
+            for (size_t i = frames; i-- > 0;) {
+                decoded[i * 2] = decoded[i * 2 + 1] = decoded[i];
+            }
+        }
+
+        pendingFrames = resampler.process(decoded, frames, pending);
+        if (eof) {
+            pendingFrames += resampler.flush(pending + pendingFrames * 2);
+        }
+        pendingPos = 0;
+        return pendingFrames;
+    }
+
+    // Next chunk of bank PCM (already 48kHz stereo) into pending
+    size_t copyBankChunk() {
+        size_t frames = static_cast<size_t>(std::min<uint64_t>(CHUNK_FRAMES, bankFrames - bankPos));
+        size_t first = static_cast<size_t>(bankPos) * 2;
+        if (bankFormat == DubSiren::SampleBank::FORMAT_S16) {
+            DubSiren::SampleConverter::toFloat(static_cast<const int16_t*>(bankData) + first, pending, frames * 2);
+        } else {
+            std::memcpy(pending, static_cast<const float*>(bankData) + first, frames * 2 * sizeof(float));
+        }
+
+        bankPos += frames;
+        eof = (bankPos == bankFrames);
+        pendingFrames = frames;
+        pendingPos = 0;
+        return pendingFrames;
+    }
+};
+
+class AudioFilePlayer::LibraryReader {
+public:
+    // Counted in before the pointer is read, while publishLibrary() stores
+    // the pointer before reading the count (both sequentially consistent):
+    // either the loader waits for this reader or the reader sees the new library
+    explicit LibraryReader(const AudioFilePlayer& player)
+        : readers(player.libraryReaders)
+    {
+        readers.fetch_add(1);
+        current = player.library.load();
+    }
+
+    ~LibraryReader() {
+        readers.fetch_sub(1);
+    }
+
+    LibraryReader(const LibraryReader&) = delete;
+    LibraryReader& operator=(const LibraryReader&) = delete;
+
+    // Valid until the reader goes out of scope; null before the first load
+    const SampleLibrary* get() const { return current; }
+
+    const AudioFile* file(int index) const {
+        if (!current || index < 0 || index >= static_cast<int>(current->files.size())) {
+            return nullptr;
+        }
+        return &current->files[index];
+    }
+
+private:
+    std::atomic<int>& readers;
+    const SampleLibrary* current;
+};
+
+void AudioFilePlayer::FrameStore::allocate(size_t frames, SampleStorage storage) {
+    if (storage == SampleStorage::Int16) {
+        pcm.reset(new int16_t[frames * 2]());
+    } else {
+        floats.reset(new float[frames * 2]());
+    }
+}
+
+void AudioFilePlayer::FrameStore::write(size_t frame, const float* input, size_t frames,
+                                        DubSiren::SampleConverter& converter, bool quantized) {
+    if (pcm && quantized) {
+        DubSiren::SampleConverter::roundToS16(input, pcm.get() + frame * 2, frames * 2);
+    } else if (pcm) {
+        converter.convert(input, pcm.get() + frame * 2, frames * 2);
+    } else {
+        std::memcpy(floats.get() + frame * 2, input, frames * 2 * sizeof(float));
+    }
+}
+
+void AudioFilePlayer::FrameStore::read(size_t frame, float* output, size_t frames) const {
+    if (pcm) {
+        DubSiren::SampleConverter::toFloat(pcm.get() + frame * 2, output, frames * 2);
+    } else {
+        std::memcpy(output, floats.get() + frame * 2, frames * 2 * sizeof(float));
+    }
+}
+
+AudioFilePlayer::AudioFilePlayer(SampleStorage storage)
+    : storage(storage)
+{
 }
 
 AudioFilePlayer::~AudioFilePlayer() {
+    cancelLoad();
+    stopDecoder();
 }
 
+// MP3 files being checked in the background, in directory order
+struct AudioFilePlayer::LoadJob {
+    enum State { PENDING, READY, FAILED };
+
+    std::vector<std::string> paths;
+    CueMap cues;                   // By file name
+    std::vector<AudioFile> files;  // Slot per path, written by the worker that checks it
+    std::vector<State> states;     // Under mutex
+    std::atomic<size_t> nextPath{0};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool cancelled = false;
+    bool firstPublished = false;
+    bool finished = false;
+
+    LoadJob(std::vector<std::string> sortedPaths, CueMap fileCues)
+        : paths(std::move(sortedPaths))
+        , cues(std::move(fileCues))
+        , files(paths.size())
+        , states(paths.size(), PENDING)
+    {
+    }
+};
+
 bool AudioFilePlayer::loadFilesFromDirectory(const std::string& directory) {
-    std::lock_guard<std::mutex> lock(filesMutex);
+    std::lock_guard<std::mutex> lock(loadMutex);
 
-    audioFiles.clear();
+    // A load still checking files is abandoned; what it published stays
+    cancelLoad();
 
+    std::vector<std::string> mp3Files;
+    CueMap cues;
     try {
         if (!fs::exists(directory) || !fs::is_directory(directory)) {
             std::cerr << "Directory does not exist: " << directory << std::endl;
             return false;
         }
 
+        cues = readCues((fs::path(directory) / CUES_FILE).string());
+
+        // A prebuilt bank replaces the MP3 files next to it
+        fs::path bankPath = fs::path(directory) / BANK_FILE;
+        if (fs::exists(bankPath)) {
+            // Built aside: the current library stays in use until the swap
+            auto next = std::make_shared<SampleLibrary>();
+            if (loadBank(bankPath.string(), cues, *next)) {
+                installLibrary(std::move(next));
+                return true;
+            }
+        }
+
         // Collect all MP3 files
-        std::vector<std::string> mp3Files;
         for (const auto& entry : fs::directory_iterator(directory)) {
             if (entry.is_regular_file()) {
                 std::string extension = entry.path().extension().string();
@@ -56,183 +366,974 @@ bool AudioFilePlayer::loadFilesFromDirectory(const std::string& directory) {
         // Sort files alphabetically
         std::sort(mp3Files.begin(), mp3Files.end());
 
-        // Load each MP3 file
-        for (const auto& filepath : mp3Files) {
-            AudioFile audioFile;
-            if (loadMP3File(filepath, audioFile)) {
-                audioFile.filename = fs::path(filepath).filename().string();
-                audioFiles.push_back(std::move(audioFile));
-                std::cout << "Loaded MP3: " << audioFile.filename << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading MP3 files: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (mp3Files.empty()) {
+        std::cerr << "No MP3 files found in directory: " << directory << std::endl;
+        return false;
+    }
+
+    // Files are checked on a worker pool. Return as soon as the first one
+    // is playable; the rest join the library in order as they are checked.
+    loadJob = std::make_unique<LoadJob>(std::move(mp3Files), std::move(cues));
+    loading.store(true);
+    loaderThread = std::thread(&AudioFilePlayer::loaderLoop, this, std::ref(*loadJob));
+
+    std::unique_lock<std::mutex> jobLock(loadJob->mutex);
+    loadJob->changed.wait(jobLock, [this] { return loadJob->firstPublished || loadJob->finished; });
+    if (!loadJob->firstPublished) {
+        std::cerr << "No playable MP3 files in directory: " << directory << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AudioFilePlayer::loaderLoop(LoadJob& job) {
+    size_t count = job.paths.size();
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t workers = std::min<size_t>(count, std::min(MAX_LOAD_WORKERS, cores));
+
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&job, count] {
+            auto probe = std::make_unique<DecodeStream>();
+            while (true) {
+                size_t index = job.nextPath.fetch_add(1);
+                if (index >= count) {
+                    break;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(job.mutex);
+                    if (job.cancelled) {
+                        break;
+                    }
+                }
+
+                AudioFile& file = job.files[index];
+                auto cues = job.cues.find(fs::path(job.paths[index]).filename().string());
+                if (cues != job.cues.end()) {
+                    file.cues = cues->second;
+                }
+                bool ok = probeMP3File(*probe, job.paths[index], file);
+                if (ok) {
+                    file.path = job.paths[index];
+                    file.filename = fs::path(file.path).filename().string();
+                }
+
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.states[index] = ok ? LoadJob::READY : LoadJob::FAILED;
+                job.changed.notify_all();
             }
-        }
+        });
+    }
 
-        if (audioFiles.empty()) {
-            std::cerr << "No MP3 files found in directory: " << directory << std::endl;
-            return false;
+    // Merge in directory order, so the library (and every file's index)
+    // is the same however the workers were scheduled
+    std::vector<AudioFile> ready;
+    size_t next = 0;
+    while (next < count) {
+        size_t before = ready.size();
+        {
+            std::unique_lock<std::mutex> lock(job.mutex);
+            job.changed.wait(lock, [&] { return job.cancelled || job.states[next] != LoadJob::PENDING; });
+            if (job.cancelled) {
+                break;
+            }
+            for (; next < count && job.states[next] != LoadJob::PENDING; ++next) {
+                if (job.states[next] == LoadJob::READY) {
+                    ready.push_back(job.files[next]);
+                }
+            }
         }
 
-        currentFileIndex.store(0);
-        playbackPosition.store(0);
-        finished.store(false);
+        if (ready.size() > before) {
+            for (size_t i = before; i < ready.size(); ++i) {
+                std::cout << "Found MP3: " << ready[i].filename << " (" << ready[i].sampleRate << " Hz, "
+                          << (ready[i].channels == 1 ? "mono" : "stereo");
+                if (!ready[i].cues.empty()) {
+                    std::cout << ", " << ready[i].cues.size() << " cue(s)";
+                }
+                std::cout << ")" << std::endl;
+            }
 
-        std::cout << "Loaded " << audioFiles.size() << " MP3 file(s)" << std::endl;
-        return true;
+            auto library = std::make_shared<SampleLibrary>();
+            library->files = ready;
+            if (before == 0) {
+                installLibrary(std::move(library));
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.firstPublished = true;
+                job.changed.notify_all();
+            } else {
+                publishLibrary(std::move(library));
+            }
+        }
+    }
 
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading MP3 files: " << e.what() << std::endl;
-        return false;
+    for (std::thread& worker : pool) {
+        worker.join();
     }
+
+    if (next == count && !ready.empty()) {
+        std::cout << "Loaded " << ready.size() << " MP3 file(s)" << std::endl;
+    }
+
+    loading.store(false);
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.finished = true;
+    job.changed.notify_all();
 }
 
-bool AudioFilePlayer::loadMP3File(const std::string& filepath, AudioFile& audioFile) {
-    mp3dec_t mp3d;
-    mp3dec_file_info_t info;
+void AudioFilePlayer::cancelLoad() {
+    if (!loaderThread.joinable()) {
+        return;
+    }
 
-    // Decode entire MP3 file
-    if (mp3dec_load(&mp3d, filepath.c_str(), &info, NULL, NULL) != 0) {
-        std::cerr << "Failed to decode MP3: " << filepath << std::endl;
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(loadJob->mutex);
+        loadJob->cancelled = true;
+        loadJob->changed.notify_all();
     }
+    loaderThread.join();
+    loadJob.reset();
+}
 
-    if (info.samples == 0) {
-        std::cerr << "MP3 file is empty: " << filepath << std::endl;
-        free(info.buffer);
-        return false;
+void AudioFilePlayer::installLibrary(std::shared_ptr<const SampleLibrary> next) {
+    playing.store(false);
+    publishLibrary(std::move(next));
+    currentFileIndex.store(0);
+    finished.store(false);
+
+    // Prime the first file; the decoder takes up the new library with it
+    selectRequests.fetch_add(1, std::memory_order_release);
+    if (decoderThread.joinable()) {
+        wakeDecoder.notify_one();
+    } else {
+        startDecoder();
     }
+}
 
-    // Store original sample rate and channels
-    int sourceSampleRate = info.hz;
-    int sourceChannels = info.channels;
+void AudioFilePlayer::publishLibrary(std::shared_ptr<const SampleLibrary> next) {
+    library.store(next.get());
 
-    // Copy samples (minimp3 with MINIMP3_FLOAT_OUTPUT gives us float samples)
-    audioFile.samples.resize(info.samples);
-    std::memcpy(audioFile.samples.data(), info.buffer, info.samples * sizeof(float));
+    // Grace period: wait out readers that may have seen the old pointer.
+    // They only copy a name or a color, so this is brief.
+    while (libraryReaders.load() != 0) {
+        std::this_thread::yield();
+    }
 
-    // Free the mp3dec buffer
-    free(info.buffer);
+    // Dropped here, or by the decoder if it is still streaming from it
+    libraryOwner = std::move(next);
+}
 
-    // Resample to 48kHz stereo if needed
-    if (sourceSampleRate != 48000 || sourceChannels != 2) {
-        resampleAudio(audioFile, sourceSampleRate, sourceChannels);
+bool AudioFilePlayer::loadBank(const std::string& path, const CueMap& cues, SampleLibrary& target) {
+    if (!target.bank.load(path)) {
+        return false;
+    }
+    if (target.bank.count() == 0) {
+        std::cerr << "[Bank] " << path << " holds no samples" << std::endl;
+        return false;
     }
 
-    audioFile.sampleRate = 48000;
-    audioFile.channels = 2;
+    for (int i = 0; i < target.bank.count(); ++i) {
+        const DubSiren::SampleBankEntry* entry = target.bank.entry(i);
+        AudioFile audioFile;
+        audioFile.path = path;
+        audioFile.filename.assign(entry->name, strnlen(entry->name, sizeof(entry->name)));
+        audioFile.bankEntry = i;
+        auto fileCues = cues.find(audioFile.filename);
+        if (fileCues != cues.end()) {
+            audioFile.cues = fileCues->second;
+        }
+        target.files.push_back(std::move(audioFile));
+    }
 
+    std::cout << "Mapped " << target.files.size() << " sample(s) from " << path << std::endl;
     return true;
 }
 
-void AudioFilePlayer::resampleAudio(AudioFile& audioFile, int sourceSampleRate, int sourceChannels) {
-    // Simple resampling: convert to stereo and/or change sample rate
-    std::vector<float> resampled;
+bool AudioFilePlayer::probeMP3File(DecodeStream& probe, const std::string& filepath, AudioFile& audioFile) {
+    if (!probe.openMP3(filepath)) {
+        std::cerr << "Failed to decode MP3: " << filepath << std::endl;
+        return false;
+    }
 
-    size_t sourceFrames = audioFile.samples.size() / sourceChannels;
+    audioFile.sampleRate = probe.dec.info.hz;
+    audioFile.channels = probe.dec.info.channels;
 
-    // Calculate target number of frames for 48kHz
-    size_t targetFrames;
-    if (sourceSampleRate != 48000) {
-        targetFrames = (sourceFrames * 48000) / sourceSampleRate;
-    } else {
-        targetFrames = sourceFrames;
+    // Files with cues get their frame index now, so starting at a cue seeks
+    // straight to the frame instead of scanning the file on the decoder
+    if (!audioFile.cues.empty() && mp3dec_ex_seek(&probe.dec, probe.channels) == 0 && probe.dec.index.frames) {
+        auto index = std::make_shared<MP3FrameIndex>();
+        index->frames.assign(probe.dec.index.frames, probe.dec.index.frames + probe.dec.index.num_frames);
+        audioFile.frameIndex = std::move(index);
     }
 
-    resampled.resize(targetFrames * 2);  // Stereo output
+    probe.close();
+    return true;
+}
 
-    for (size_t i = 0; i < targetFrames; i++) {
-        // Find corresponding source frame (simple linear interpolation)
-        float sourcePos = (float)i * sourceSampleRate / 48000.0f;
-        size_t sourceFrame = (size_t)sourcePos;
+AudioFilePlayer::CueMap AudioFilePlayer::readCues(const std::string& path) {
+    CueMap cues;
+    std::ifstream in(path);
+    if (!in) {
+        return cues;
+    }
 
-        if (sourceFrame >= sourceFrames) {
-            sourceFrame = sourceFrames - 1;
+    std::string line;
+    int lineNumber = 0;
+    int count = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
         }
 
-        float left, right;
+        // Times are the trailing numbers; the name before them may hold spaces
+        double times[3];
+        int numTimes = 0;
+        while (numTimes < 3) {
+            size_t end = line.find_last_not_of(" \t\r");
+            size_t begin = line.find_last_of(" \t", end);
+            if (end == std::string::npos || begin == std::string::npos) {
+                break;
+            }
+            std::string token = line.substr(begin + 1, end - begin);
+            char* parsed = nullptr;
+            double seconds = std::strtod(token.c_str(), &parsed);
+            if (*parsed != '\0' || !std::isfinite(seconds) || seconds < 0.0) {
+                break;
+            }
+            times[numTimes++] = seconds;
+            line.erase(begin);
+        }
+        size_t last = line.find_last_not_of(" \t");
+        std::string name = (last != std::string::npos && last >= first) ? line.substr(first, last + 1 - first) : "";
 
-        if (sourceChannels == 1) {
-            // Mono to stereo: duplicate channel
-            left = right = audioFile.samples[sourceFrame];
-        } else {
-            // Stereo: copy both channels
-            left = audioFile.samples[sourceFrame * 2];
-            right = audioFile.samples[sourceFrame * 2 + 1];
+        CuePoint cue;
+        if (numTimes == 1 || numTimes == 3) {
+            cue.start = static_cast<uint64_t>(std::llround(times[numTimes - 1] * OUTPUT_RATE));
+        }
+        if (numTimes == 3) {
+            cue.loopStart = static_cast<uint64_t>(std::llround(times[1] * OUTPUT_RATE));
+            cue.loopEnd = static_cast<uint64_t>(std::llround(times[0] * OUTPUT_RATE));
+        }
+        if (name.empty() || (numTimes != 1 && numTimes != 3) ||
+            (numTimes == 3 && (!cue.loops() || cue.start >= cue.loopEnd))) {
+            std::cerr << "[MP3] " << path << ":" << lineNumber
+                      << ": expected FILENAME START [LOOP_START LOOP_END], the loop ending after both starts"
+                      << std::endl;
+            continue;
+        }
+
+        std::vector<CuePoint>& fileCues = cues[name];
+        if (fileCues.size() == MAX_CUES) {
+            std::cerr << "[MP3] " << name << ": only the first " << MAX_CUES << " cues are used" << std::endl;
+            continue;
         }
+        fileCues.push_back(cue);
+        ++count;
+    }
+
+    std::cout << "Read " << count << " cue(s) for " << cues.size() << " file(s) from " << path << std::endl;
+    return cues;
+}
 
-        resampled[i * 2] = left;
-        resampled[i * 2 + 1] = right;
+void AudioFilePlayer::startDecoder() {
+    // Buffers are allocated once, here, and never on the audio thread
+    if (!ring.isAllocated()) {
+        ring.allocate(RING_FRAMES, storage);
+        for (Preroll& preroll : prerolls) {
+            preroll.samples.allocate(PREROLL_FRAMES, storage);
+        }
+    }
+    if (!stream) {
+        stream = std::make_unique<DecodeStream>();
+        nextStream = std::make_unique<DecodeStream>();
     }
 
-    audioFile.samples = std::move(resampled);
+    decoderRunning.store(true);
+    decoderThread = std::thread(&AudioFilePlayer::decoderLoop, this);
+}
+
+void AudioFilePlayer::stopDecoder() {
+    if (!decoderThread.joinable()) {
+        return;
+    }
+
+    decoderRunning.store(false);
+    wakeDecoder.notify_one();
+    decoderThread.join();
+}
+
+int AudioFilePlayer::getFileCount() const {
+    LibraryReader reader(*this);
+    return reader.get() ? static_cast<int>(reader.get()->files.size()) : 0;
 }
 
 void AudioFilePlayer::selectFile(int index) {
-    std::lock_guard<std::mutex> lock(filesMutex);
+    LibraryReader reader(*this);
 
-    if (index >= 0 && index < static_cast<int>(audioFiles.size())) {
+    if (const AudioFile* file = reader.file(index)) {
         currentFileIndex.store(index);
-        playbackPosition.store(0);
         finished.store(false);
-        std::cout << "Selected MP3: " << audioFiles[index].filename << std::endl;
+        selectRequests.fetch_add(1, std::memory_order_release);
+        wakeDecoder.notify_one();
+        std::cout << "Selected MP3: " << file->filename << std::endl;
     }
 }
 
 std::string AudioFilePlayer::getCurrentFileName() const {
-    std::lock_guard<std::mutex> lock(filesMutex);
+    LibraryReader reader(*this);
 
-    int index = currentFileIndex.load();
-    if (index >= 0 && index < static_cast<int>(audioFiles.size())) {
-        return audioFiles[index].filename;
+    if (const AudioFile* file = reader.file(currentFileIndex.load())) {
+        return file->filename;
     }
     return "";
 }
 
 void AudioFilePlayer::play() {
-    playbackPosition.store(0);
+    playCue(TOP);
+}
+
+void AudioFilePlayer::playCue(int cue) {
     finished.store(false);
+    // Counted before playing is set: the audio thread reads them the other way round
+    requestedCue.store(cue);
+    playRequests.fetch_add(1);
     playing.store(true);
+    wakeDecoder.notify_one();
+}
+
+int AudioFilePlayer::getCueCount() const {
+    LibraryReader reader(*this);
+
+    if (const AudioFile* file = reader.file(currentFileIndex.load())) {
+        return static_cast<int>(file->cues.size());
+    }
+    return 0;
 }
 
 void AudioFilePlayer::stop() {
     playing.store(false);
 }
 
-void AudioFilePlayer::fillBuffer(float* output, int numFrames) {
-    if (!playing.load()) {
-        // Silence
-        std::memset(output, 0, numFrames * 2 * sizeof(float));
+void AudioFilePlayer::setChained(bool chained, float crossfadeSeconds) {
+    double frames = std::round(std::max(0.0f, crossfadeSeconds) * OUTPUT_RATE);
+    chainFadeFrames.store(static_cast<size_t>(std::min(frames, static_cast<double>(MAX_CHAIN_FADE))));
+    chainFiles.store(chained);
+    wakeDecoder.notify_one();
+}
+
+float AudioFilePlayer::getChainCrossfade() const {
+    return static_cast<float>(chainFadeFrames.load()) / OUTPUT_RATE;
+}
+
+bool AudioFilePlayer::openStream(DecodeStream& s, const AudioFile& file, uint64_t start, size_t prerollFrames,
+                                 uint64_t length, Preroll* target) {
+    const DubSiren::SampleBank& bank = s.library->bank;
+    const DubSiren::SampleBankEntry* entry = bank.entry(file.bankEntry);
+    if (entry) {
+        s.openBank(bank, *entry);
+    } else if (s.openMP3(file.path)) {
+        s.resampler.configure(s.dec.info.hz, OUTPUT_RATE);
+    } else {
+        std::cerr << "[MP3] Cannot open " << file.path << std::endl;
+        if (target) {
+            target->frames = 0;
+        }
+        return false;
+    }
+
+    // An MP3 seek starts a little early, on an output frame that falls on a
+    // source sample, and drops the lead: the resampler's history is then
+    // full and the stream matches playing through from the top sample for
+    // sample, so a loop has no seam
+    uint64_t lead = 0;
+    if (!entry && start > 0) {
+        uint64_t hz = static_cast<uint64_t>(s.dec.info.hz);
+        uint64_t step = OUTPUT_RATE / std::gcd(hz, static_cast<uint64_t>(OUTPUT_RATE));
+        uint64_t warmup = DubSiren::PolyphaseResampler::TAPS * OUTPUT_RATE / hz + 1;
+        uint64_t from = start > warmup ? (start - warmup) / step * step : 0;
+        lead = start - from;
+        start = from;
+    }
+    if (!s.seek(start, file.frameIndex.get())) {
+        std::cerr << "[MP3] Cannot seek " << file.filename << " to frame " << start << std::endl;
+    }
+
+    // The rest of the last chunk stays pending for the ring, so a restart
+    // that decodes the same frames again resumes exactly where the preroll ends
+    size_t frames = 0;
+    while (frames < prerollFrames || lead > 0) {
+        if (s.pendingPos == s.pendingFrames) {
+            if (s.eof) {
+                break;
+            }
+            s.decodeChunk();
+            continue;
+        }
+
+        size_t available = s.pendingFrames - s.pendingPos;
+        if (lead > 0) {
+            size_t dropped = static_cast<size_t>(std::min<uint64_t>(lead, available));
+            s.pendingPos += dropped;
+            lead -= dropped;
+            continue;
+        }
+
+        size_t used = std::min(available, prerollFrames - frames);
+        if (target) {
+            target->samples.write(frames, s.pending + s.pendingPos * 2, used, s.converter, s.isQuantized());
+        }
+        s.pendingPos += used;
+        frames += used;
+    }
+
+    if (target) {
+        target->frames = frames;
+    }
+
+    // A segment that ends at a loop end stops the stream there
+    s.chainable = (length == 0);
+    if (length != 0) {
+        uint64_t left = length - std::min<uint64_t>(length, frames);
+        size_t buffered = s.pendingFrames - s.pendingPos;
+        if (buffered >= left) {
+            s.pendingFrames = s.pendingPos + static_cast<size_t>(left);
+            s.eof = true;
+        } else {
+            s.remaining = left - buffered;
+        }
+    }
+    return true;
+}
+
+void AudioFilePlayer::prepareCues(DecodeStream& s, const AudioFile& file, CueSet& cueSet) {
+    cueSet.count = 0;
+    if (file.cues.empty()) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(filesMutex);
+    // Only players that meet a file with cues pay for their prerolls
+    if (!cueSet.entries[0].samples.isAllocated()) {
+        for (Preroll& entry : cueSet.entries) {
+            entry.samples.allocate(CUE_PREROLL_FRAMES, storage);
+        }
+    }
 
-    int index = currentFileIndex.load();
-    if (index < 0 || index >= static_cast<int>(audioFiles.size())) {
-        std::memset(output, 0, numFrames * 2 * sizeof(float));
+    uint64_t entryStart[MAX_CUE_ENTRIES];
+    int entries = 0;
+    auto entryAt = [&](uint64_t frame) {
+        for (int e = 0; e < entries; ++e) {
+            if (entryStart[e] == frame) {
+                return e;
+            }
+        }
+        entryStart[entries] = frame;
+        openStream(s, file, frame, CUE_PREROLL_FRAMES, 0, &cueSet.entries[entries]);
+        return entries++;
+    };
+
+    for (size_t i = 0; i < file.cues.size() && i < MAX_CUES; ++i) {
+        const CuePoint& point = file.cues[i];
+        CueSet::Cue& cue = cueSet.cues[cueSet.count++];
+        cue.entry = entryAt(point.start);
+        cue.loopEntry = point.loops() ? entryAt(point.loopStart) : -1;
+        cue.length = point.loops() ? point.loopEnd - point.start : 0;
+        cue.loopLength = point.loops() ? point.loopEnd - point.loopStart : 0;
+    }
+}
+
+void AudioFilePlayer::restartStream(const AudioFile& file, int target) {
+    int slot = streamSlot.load(std::memory_order_relaxed);
+    if (target == TOP) {
+        openStream(*stream, file, 0, prerolls[slot].frames, 0, nullptr);
+        return;
+    }
+
+    const CueSet& cueSet = cueSets[slot];
+    int index = target / 2;
+    bool loop = (target % 2) != 0;
+    if (index >= cueSet.count || index >= static_cast<int>(file.cues.size()) ||
+        (loop && cueSet.cues[index].loopEntry < 0)) {
+        stream->close();  // Ends at once
+        return;
+    }
+
+    const CueSet::Cue& cue = cueSet.cues[index];
+    const CuePoint& point = file.cues[index];
+    if (loop) {
+        openStream(*stream, file, point.loopStart, cueSet.entries[cue.loopEntry].frames, cue.loopLength, nullptr);
+    } else {
+        openStream(*stream, file, point.start, cueSet.entries[cue.entry].frames, cue.length, nullptr);
+    }
+}
+
+void AudioFilePlayer::publishStream(int slot, bool chained) {
+    uint32_t serial = ++publishedSerial;
+    stream->serial = serial;
+    streamStart.store(ringWrite.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    streamSlot.store(slot, std::memory_order_relaxed);
+    streamFile.store(stream->fileIndex, std::memory_order_relaxed);
+    streamRewinds.store(handledRewinds, std::memory_order_relaxed);
+    streamSelects.store(handledSelects, std::memory_order_relaxed);
+    streamChained.store(chained, std::memory_order_relaxed);
+    streamSerial.store(serial, std::memory_order_release);
+}
+
+int AudioFilePlayer::chainTarget() const {
+    const DecodeStream& s = *stream;
+    if (!chainFiles.load(std::memory_order_relaxed) || !s.chainable || s.fileIndex < 0) {
+        return -1;
+    }
+    LibraryReader reader(*this);
+    return reader.file(s.fileIndex + 1) ? s.fileIndex + 1 : -1;
+}
+
+void AudioFilePlayer::prefetchFile(int index) {
+    // A library published since the last select only adds files (a new
+    // load selects a file of its own), so the next file comes from the newest
+    {
+        LibraryReader reader(*this);
+        if (!reader.file(index)) {
+            return;
+        }
+        nextStream->library = reader.get()->shared_from_this();
+    }
+
+    int slot = 1 - streamSlot.load(std::memory_order_relaxed);
+    const AudioFile& file = nextStream->library->files[index];
+    nextStream->fileIndex = index;
+    prepareCues(*nextStream, file, cueSets[slot]);
+    openStream(*nextStream, file, 0, PREROLL_FRAMES, 0, &prerolls[slot]);
+    nextFile = index;
+}
+
+void AudioFilePlayer::publishChain() {
+    int slot = 1 - streamSlot.load(std::memory_order_relaxed);
+    stream.swap(nextStream);
+    nextFile = -1;
+    chainPending = true;
+    publishStream(slot, true);
+}
+
+void AudioFilePlayer::settleChain() {
+    chainPending = false;
+    if (chainTaken.load(std::memory_order_relaxed) == publishedSerial) {
         return;
     }
 
-    const AudioFile& file = audioFiles[index];
-    size_t pos = playbackPosition.load();
-    size_t totalSamples = file.samples.size();  // Interleaved stereo
+    // Declined: back to the file that ended, for a rewind to restart. Its
+    // end, where the chained stream started, is published again in case the
+    // chained stream's replaced it, and is not chained again.
+    size_t end = streamStart.load(std::memory_order_relaxed);
+    stream.swap(nextStream);
+    nextStream->close();
+    stream->chainable = false;
+    streamSlot.store(1 - streamSlot.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    eofPos.store(end, std::memory_order_relaxed);
+    eofSerial.store(stream->serial, std::memory_order_release);
+}
+
+bool AudioFilePlayer::fillRing() {
+    DecodeStream& s = *stream;
+    bool progressed = false;
+
+    while (true) {
+        if (s.pendingPos == s.pendingFrames) {
+            if (s.eof) {
+                break;
+            }
+            s.decodeChunk();
+            progressed = true;
+            continue;
+        }
+
+        size_t head = ringWrite.load(std::memory_order_relaxed);
+        size_t space = RING_FRAMES - (head - ringRead.load(std::memory_order_acquire));
+        if (space == 0) {
+            break;
+        }
+
+        size_t frames = std::min(space, s.pendingFrames - s.pendingPos);
+        size_t start = head & (RING_FRAMES - 1);
+        size_t first = std::min(frames, RING_FRAMES - start);
+        ring.write(start, s.pending + s.pendingPos * 2, first, s.converter, s.isQuantized());
+        ring.write(0, s.pending + (s.pendingPos + first) * 2, frames - first, s.converter, s.isQuantized());
+        ringWrite.store(head + frames, std::memory_order_release);
+        s.pendingPos += frames;
+        progressed = true;
+    }
+
+    // Tell the audio thread where this stream ends. In chain mode the next
+    // file is published with it, so the end waits until that is prefetched.
+    if (s.eof && s.pendingPos == s.pendingFrames && eofSerial.load(std::memory_order_relaxed) != s.serial) {
+        int next = chainTarget();
+        if (next >= 0 && next != nextFile) {
+            return progressed;
+        }
+        eofPos.store(ringWrite.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        eofSerial.store(s.serial, std::memory_order_release);
+        if (next >= 0) {
+            publishChain();
+            progressed = true;
+        }
+    }
+
+    return progressed;
+}
+
+void AudioFilePlayer::decoderLoop() {
+    while (decoderRunning.load()) {
+        // Publish at most one stream ahead of the audio thread, so the preroll
+        // slot it is playing is never written
+        if (ackedSerial.load(std::memory_order_acquire) == publishedSerial) {
+            if (chainPending) {
+                settleChain();
+            }
+
+            DecodeStream& s = *stream;
+            uint32_t selects = selectRequests.load(std::memory_order_acquire);
+            uint32_t rewinds = rewindRequests.load(std::memory_order_acquire);
+
+            if (selects != handledSelects) {
+                // A new file starts from the top anyway: pending rewinds are moot
+                handledSelects = selects;
+                handledRewinds = rewinds;
+                s.fileIndex = currentFileIndex.load();
+
+                // Take up a newly published library; the old one is released
+                // here if nothing else holds it
+                {
+                    LibraryReader reader(*this);
+                    if (reader.get() != s.library.get()) {
+                        s.close();
+                        s.library = reader.get() ? reader.get()->shared_from_this() : nullptr;
+                        nextStream->close();
+                        nextStream->library = s.library;
+                    }
+                }
+
+                // The free slot is filled again: any prefetch there is gone
+                nextFile = -1;
+                int fileCount = s.library ? static_cast<int>(s.library->files.size()) : 0;
+                int slot = 1 - streamSlot.load(std::memory_order_relaxed);
+                if (s.fileIndex >= 0 && s.fileIndex < fileCount) {
+                    const AudioFile& file = s.library->files[s.fileIndex];
+                    prepareCues(s, file, cueSets[slot]);
+                    openStream(s, file, 0, PREROLL_FRAMES, 0, &prerolls[slot]);
+                } else {
+                    s.close();
+                    prerolls[slot].frames = 0;
+                    cueSets[slot].count = 0;
+                }
+                publishStream(slot);
+            } else if (rewinds != handledRewinds) {
+                // Same preroll; decode past it again so the ring resumes where it ends.
+                // The target was stored before the request was counted.
+                handledRewinds = rewinds;
+                int target = rewindTarget.load(std::memory_order_relaxed);
+                if (s.library && s.fileIndex >= 0 && s.fileIndex < static_cast<int>(s.library->files.size())) {
+                    restartStream(s.library->files[s.fileIndex], target);
+                }
+                publishStream(streamSlot.load(std::memory_order_relaxed));
+            } else {
+                // Chain mode: get the next file ready while this one plays
+                int next = chainTarget();
+                if (next >= 0 && next != nextFile) {
+                    prefetchFile(next);
+                }
+            }
+        }
+
+        bool progressed = fillRing();
+
+        uint64_t dropouts = underruns.load(std::memory_order_relaxed);
+        if (dropouts != reportedUnderruns) {
+            std::cerr << "[MP3] Decoder fell behind: " << dropouts << " blocks of silence so far" << std::endl;
+            reportedUnderruns = dropouts;
+        }
+
+        // The audio thread never signals; poll for ring space and rewinds
+        if (!progressed) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeDecoder.wait_for(lock, std::chrono::milliseconds(DECODER_POLL_MS));
+        }
+    }
+
+    stream->close();
+    nextStream->close();
+}
 
-    int samplesNeeded = numFrames * 2;  // Stereo
-    int samplesCopied = 0;
+const AudioFilePlayer::Preroll& AudioFilePlayer::prerollFor(int target) const {
+    if (target == TOP) {
+        return prerolls[activeSlot];
+    }
+    const CueSet& cueSet = cueSets[activeSlot];
+    const CueSet::Cue& cue = cueSet.cues[target / 2];
+    return cueSet.entries[target % 2 ? cue.loopEntry : cue.entry];
+}
 
-    while (samplesCopied < samplesNeeded && pos < totalSamples) {
-        output[samplesCopied++] = file.samples[pos++];
+uint64_t AudioFilePlayer::segmentLength(int target) const {
+    if (target == TOP) {
+        return 0;
     }
+    const CueSet::Cue& cue = cueSets[activeSlot].cues[target / 2];
+    return target % 2 ? cue.loopLength : cue.length;
+}
+
+void AudioFilePlayer::startSegment(int target) {
+    activeTarget = target;
+    prerollPos = 0;
 
-    // Fill remaining with silence if we reached the end
-    if (samplesCopied < samplesNeeded) {
-        std::memset(output + samplesCopied, 0, (samplesNeeded - samplesCopied) * sizeof(float));
-        playing.store(false);
-        finished.store(true);
+    uint64_t length = segmentLength(target);
+    if (length != 0 && length <= prerollFor(target).frames) {
+        return;  // Played from the preroll alone
     }
+    if (ringConsumed || ringTarget != target) {
+        requestStream(target);
+    }
+}
 
-    playbackPosition.store(pos);
+void AudioFilePlayer::requestStream(int target) {
+    // The ring has moved on, or holds another segment: the decoder restarts
+    // it behind the target's preroll
+    ringTarget = target;
+    ringConsumed = false;
+    awaitingStream = true;
+    rewindTarget.store(target, std::memory_order_relaxed);
+    rewindRequests.fetch_add(1, std::memory_order_release);
+    ++sentRewinds;
+}
+
+bool AudioFilePlayer::chainFollows() const {
+    return !awaitingStream && ringTarget == activeTarget && segmentLength(activeTarget) == 0 &&
+           streamRewinds.load(std::memory_order_relaxed) == sentRewinds &&
+           selectRequests.load(std::memory_order_relaxed) == streamSelects.load(std::memory_order_relaxed);
+}
+
+void AudioFilePlayer::offerChain(uint32_t serial) {
+    chainOffered = true;
+    offeredSerial = serial;
+
+    // The playing stream ends where this one starts (its own end may be
+    // published before it is taken up). Only frames still to come from the
+    // ring are crossfaded.
+    chainEnd = streamStart.load(std::memory_order_relaxed);
+    size_t left = chainEnd - ringRead.load(std::memory_order_relaxed);
+    size_t preroll = prerolls[streamSlot.load(std::memory_order_relaxed)].frames;
+    chainFade = std::min({chainFadeFrames.load(std::memory_order_relaxed), left, preroll});
+}
+
+void AudioFilePlayer::takeChain() {
+    int file = streamFile.load(std::memory_order_relaxed);
+    activeSerial = ringSerial = offeredSerial;
+    activeSlot = streamSlot.load(std::memory_order_relaxed);
+    activeTarget = ringTarget = TOP;
+    prerollPos = chainFade;  // Already played under the crossfade
+    ringRead.store(streamStart.load(std::memory_order_relaxed), std::memory_order_release);
+    ringConsumed = false;
+    chainOffered = false;
+
+    // The next file becomes the current one, unless another was selected meanwhile
+    int expected = activeFile;
+    currentFileIndex.compare_exchange_strong(expected, file);
+    activeFile = file;
+
+    chainTaken.store(offeredSerial, std::memory_order_relaxed);
+    ackedSerial.store(offeredSerial, std::memory_order_release);
+}
+
+void AudioFilePlayer::declineChain() {
+    chainOffered = false;
+    activeSerial = offeredSerial;
+    ackedSerial.store(offeredSerial, std::memory_order_release);
+}
+
+bool AudioFilePlayer::ringEnd(size_t& end) const {
+    if (chainOffered) {
+        end = chainEnd;
+        return true;
+    }
+    if (eofSerial.load(std::memory_order_acquire) != ringSerial) {
+        return false;
+    }
+    end = eofPos.load(std::memory_order_relaxed);
+    return true;
+}
+
+void AudioFilePlayer::crossfadeChain(float* block, size_t pos, size_t frames) const {
+    static constexpr size_t CHUNK = 64;
+    const Preroll& next = prerolls[streamSlot.load(std::memory_order_relaxed)];
+    size_t fadeStart = chainEnd - chainFade;
+    size_t from = std::max(pos, fadeStart);
+    size_t to = pos + frames;
+
+    // Equal power: the files are unrelated, so their levels add as powers
+    float incoming[CHUNK * 2];
+    while (from < to) {
+        size_t count = std::min(CHUNK, to - from);
+        size_t offset = from - fadeStart;
+        next.samples.read(offset, incoming, count);
+        float* frame = block + (from - pos) * 2;
+        for (size_t i = 0; i < count; ++i) {
+            float angle = static_cast<float>(M_PI / 2) * (static_cast<float>(offset + i) + 0.5f) / chainFade;
+            float fadeOut = std::cos(angle);
+            float fadeIn = std::sin(angle);
+            frame[i * 2] = frame[i * 2] * fadeOut + incoming[i * 2] * fadeIn;
+            frame[i * 2 + 1] = frame[i * 2 + 1] * fadeOut + incoming[i * 2 + 1] * fadeIn;
+        }
+        from += count;
+    }
+}
+
+void AudioFilePlayer::fillBuffer(float* output, int numFrames) {
+    // Take up a stream the decoder has published: whatever is left of the
+    // previous one in the ring is dropped. A stream answering an older
+    // rewind than the last one sent is only acknowledged. A chained stream
+    // waits for the end of the file playing.
+    uint32_t published = streamSerial.load(std::memory_order_acquire);
+    if (published != activeSerial && !chainOffered) {
+        if (streamChained.load(std::memory_order_relaxed)) {
+            offerChain(published);
+        } else {
+            int slot = streamSlot.load(std::memory_order_relaxed);
+            bool current = streamRewinds.load(std::memory_order_relaxed) == sentRewinds;
+            bool newFile = (slot != activeSlot);
+            activeSerial = published;
+            activeSelects = streamSelects.load(std::memory_order_relaxed);
+            if (newFile) {
+                // A newly selected file starts from the top
+                activeSlot = slot;
+                activeFile = streamFile.load(std::memory_order_relaxed);
+                activeTarget = ringTarget = TOP;
+                prerollPos = 0;
+            }
+            if (current) {
+                ringSerial = published;
+                ringRead.store(streamStart.load(std::memory_order_relaxed), std::memory_order_release);
+                ringConsumed = false;
+                awaitingStream = false;
+            }
+            ackedSerial.store(published, std::memory_order_release);
+            if (newFile && !current) {
+                requestStream(TOP);  // A rewind sent for the previous file is still on its way
+            }
+        }
+    }
+
+    // Until the stream answering the last select is taken up, the slots
+    // hold the previous file: a play waits for the new one, in silence
+    bool selecting = selectRequests.load(std::memory_order_acquire) != activeSelects;
+
+    bool isPlaying = playing.load();
+    uint32_t plays = playRequests.load();
+    if (plays != handledPlays && !selecting) {
+        handledPlays = plays;
+        int cue = requestedCue.load();
+        startSegment(cue >= 0 && cue < cueSets[activeSlot].count ? 2 * cue : TOP);
+    }
+
+    // Retriggering elsewhere or selecting another file declines the next one
+    if (chainOffered && !chainFollows()) {
+        declineChain();
+    }
+
+    if (!isPlaying || selecting) {
+        // Silence
+        std::memset(output, 0, numFrames * 2 * sizeof(float));
+        return;
+    }
+
+    float* out = output;
+    size_t remaining = static_cast<size_t>(numFrames);
+
+    while (remaining > 0) {
+        const Preroll& preroll = prerollFor(activeTarget);
+        uint64_t length = segmentLength(activeTarget);
+        bool streamed = (length == 0 || length > preroll.frames);
+        size_t prerollEnd = streamed ? preroll.frames : static_cast<size_t>(length);
+
+        if (prerollPos < prerollEnd) {
+            size_t frames = std::min(remaining, prerollEnd - prerollPos);
+            preroll.samples.read(prerollPos, out, frames);
+            prerollPos += frames;
+            out += frames * 2;
+            remaining -= frames;
+            continue;
+        }
+
+        if (streamed) {
+            if (awaitingStream) {
+                break;
+            }
+
+            // Past the stream's end the ring may hold a chained stream's
+            // frames, written after the end was published
+            size_t tail = ringRead.load(std::memory_order_relaxed);
+            size_t end = ringWrite.load(std::memory_order_acquire);
+            bool ended = ringEnd(end);
+            size_t frames = std::min(remaining, end - tail);
+            if (frames > 0) {
+                size_t start = tail & (RING_FRAMES - 1);
+                size_t first = std::min(frames, RING_FRAMES - start);
+                ring.read(start, out, first);
+                ring.read(0, out + first * 2, frames - first);
+                if (chainOffered && chainFade > 0) {
+                    crossfadeChain(out, tail, frames);
+                }
+                ringRead.store(tail + frames, std::memory_order_release);
+                ringConsumed = true;
+                out += frames * 2;
+                remaining -= frames;
+            }
+
+            if (!ended) {
+                ended = ringEnd(end);  // Published meanwhile: nothing past it was read
+            }
+            if (remaining == 0 || !ended || tail + frames != end) {
+                break;
+            }
+            ringConsumed = true;  // Used up, even if it held nothing
+        }
+
+        // End of the segment: a loop goes round again from its preroll, and
+        // in chain mode the next file follows on the next frame
+        if (activeTarget != TOP && cueSets[activeSlot].cues[activeTarget / 2].loopEntry >= 0) {
+            startSegment(activeTarget | 1);
+        } else if (chainOffered) {
+            takeChain();
+        } else {
+            // Fill remaining with silence: reached the end
+            std::memset(out, 0, remaining * 2 * sizeof(float));
+            playing.store(false);
+            finished.store(true);
+            return;
+        }
+    }
+
+    if (remaining > 0) {
+        std::memset(out, 0, remaining * 2 * sizeof(float));
+        underruns.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 AudioFilePlayer::Color AudioFilePlayer::getColorForCurrentFile() const {
+    LibraryReader reader(*this);
+
     int index = currentFileIndex.load();
+    if (const AudioFile* file = reader.file(index)) {
+        if (const DubSiren::SampleBankEntry* entry = reader.get()->bank.entry(file->bankEntry)) {
+            return {entry->color[0], entry->color[1], entry->color[2]};
+        }
+    }
+    return defaultColor(index);
+}
+
+AudioFilePlayer::Color AudioFilePlayer::defaultColor(int index) {
     return FILE_COLORS[index % NUM_COLORS];
 }
@@ -1,4 +1,6 @@
 #include "Audio/AudioOutput.h"
+#include "Audio/LatencyController.h"
+#include "Audio/AudioRecorder.h"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
@@ -31,10 +33,25 @@ AudioOutput::AudioOutput(AudioEngine& engine,
     , bufferSize(bufferSize)
     , channels(channels)
     , deviceName(device ? device : "default")
+    , useMmap(true)
+    , formatForced(false)
+    , forcedFormat(SampleFormat::S16)
+    , adaptiveLatency(false)
+    , periodCount(3)
+    , recorder(nullptr)
+    , duplex(false)
+    , mmapActive(false)
+    , periodFrames(bufferSize)
+    , ringFrames(bufferSize * 3)
+    , captureFormat(SampleFormat::S16)
+    , captureMmap(false)
+    , captureOffset(0)
     , running(false)
     , totalBuffers(0)
     , underruns(0)
+    , captureOverruns(0)
     , lastCpuUsage(0.0f)
+    , lastHeadroomMs(0.0f)
 {
 }
 
@@ -83,12 +100,17 @@ void AudioOutput::stop() {
         std::cout << "\nAudio performance:" << std::endl;
         std::cout << "  Total buffers: " << total << std::endl;
         std::cout << "  Buffer underruns: " << under << " (" << underrunRate << "%)" << std::endl;
+        if (duplex) {
+            std::cout << "  Capture overruns: " << captureOverruns.load() << std::endl;
+        }
     }
     
     std::cout << "Audio output stopped" << std::endl;
 }
 
-void AudioOutput::setRealtimePriority() {
+// Shared by the ALSA and simulated outputs; returns false if still
+// running at normal priority
+static bool promoteThreadToRealtime() {
 #ifdef __linux__
     // Set SCHED_FIFO real-time scheduling for the audio thread.
     // This prevents normal-priority processes from preempting audio,
@@ -104,17 +126,33 @@ void AudioOutput::setRealtimePriority() {
             std::cerr << "[Audio] Warning: Could not set real-time priority (error "
                       << err << "). Run as root or set rtprio in /etc/security/limits.conf"
                       << std::endl;
-        } else {
-            std::cout << "[Audio] Using SCHED_RR priority " << param.sched_priority << std::endl;
+            return false;
         }
+        std::cout << "[Audio] Using SCHED_RR priority " << param.sched_priority << std::endl;
     } else {
         std::cout << "[Audio] Using SCHED_FIFO priority " << param.sched_priority << std::endl;
     }
+    return true;
+#else
+    return false;
 #endif
 }
 
+void AudioOutput::setRealtimePriority() {
+    promoteThreadToRealtime();
+}
+
 #ifdef HAVE_ALSA
-bool AudioOutput::configureAlsa(snd_pcm_t* pcm) {
+static snd_pcm_format_t toAlsaFormat(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::S32: return SND_PCM_FORMAT_S32_LE;
+        case SampleFormat::S24: return SND_PCM_FORMAT_S24_LE;
+        case SampleFormat::S16:
+        default:                return SND_PCM_FORMAT_S16_LE;
+    }
+}
+
+bool AudioOutput::configureAlsa(snd_pcm_t* pcm, int requestedPeriod, int requestedPeriods) {
     int err;
     snd_pcm_hw_params_t* hwParams = nullptr;
     snd_pcm_sw_params_t* swParams = nullptr;
@@ -128,15 +166,37 @@ bool AudioOutput::configureAlsa(snd_pcm_t* pcm) {
         return false;
     }
 
-    err = snd_pcm_hw_params_set_access(pcm, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
-    if (err < 0) {
-        std::cerr << "[ALSA] Cannot set access type: " << snd_strerror(err) << std::endl;
-        return false;
+    // Prefer mmap access (render straight into the DMA ring); not every
+    // device or plugin chain supports it, so fall back to read/write
+    mmapActive = useMmap
+        && snd_pcm_hw_params_set_access(pcm, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0;
+    if (!mmapActive) {
+        err = snd_pcm_hw_params_set_access(pcm, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+        if (err < 0) {
+            std::cerr << "[ALSA] Cannot set access type: " << snd_strerror(err) << std::endl;
+            return false;
+        }
     }
 
-    err = snd_pcm_hw_params_set_format(pcm, hwParams, SND_PCM_FORMAT_S16_LE);
-    if (err < 0) {
-        std::cerr << "[ALSA] Cannot set format: " << snd_strerror(err) << std::endl;
+    // Widest format first: the PCM5102 takes 32-bit I2S frames, and 16 bit
+    // needs dither to keep quiet tails clean
+    static constexpr SampleFormat formatOrder[] = {
+        SampleFormat::S32, SampleFormat::S24, SampleFormat::S16
+    };
+    bool formatSet = false;
+    for (SampleFormat format : formatOrder) {
+        if (formatForced && format != forcedFormat) {
+            continue;
+        }
+        if (snd_pcm_hw_params_test_format(pcm, hwParams, toAlsaFormat(format)) == 0
+            && snd_pcm_hw_params_set_format(pcm, hwParams, toAlsaFormat(format)) >= 0) {
+            converter.setFormat(format);
+            formatSet = true;
+            break;
+        }
+    }
+    if (!formatSet) {
+        std::cerr << "[ALSA] Cannot set format: no supported sample format" << std::endl;
         return false;
     }
 
@@ -153,19 +213,19 @@ bool AudioOutput::configureAlsa(snd_pcm_t* pcm) {
         return false;
     }
 
-    // Set period size to match our processing buffer size.
-    // This ensures each snd_pcm_writei call fills exactly one period,
+    // Set period size to match our processing block size.
+    // This ensures each write fills exactly one period,
     // giving predictable wake-up timing.
-    snd_pcm_uframes_t periodSize = static_cast<snd_pcm_uframes_t>(bufferSize);
+    snd_pcm_uframes_t periodSize = static_cast<snd_pcm_uframes_t>(requestedPeriod);
     err = snd_pcm_hw_params_set_period_size_near(pcm, hwParams, &periodSize, nullptr);
     if (err < 0) {
         std::cerr << "[ALSA] Cannot set period size: " << snd_strerror(err) << std::endl;
         return false;
     }
 
-    // Use 3 periods for the ring buffer: gives ~16ms of safety margin at
+    // Default 3 periods for the ring buffer: gives ~16ms of safety margin at
     // 256 samples/period @ 48kHz while keeping latency reasonable.
-    unsigned int periods = 3;
+    unsigned int periods = static_cast<unsigned int>(requestedPeriods);
     err = snd_pcm_hw_params_set_periods_near(pcm, hwParams, &periods, nullptr);
     if (err < 0) {
         std::cerr << "[ALSA] Cannot set period count: " << snd_strerror(err) << std::endl;
@@ -183,9 +243,14 @@ bool AudioOutput::configureAlsa(snd_pcm_t* pcm) {
     snd_pcm_hw_params_get_period_size(hwParams, &actualPeriod, nullptr);
     snd_pcm_hw_params_get_buffer_size(hwParams, &actualBuffer);
 
+    periodFrames = static_cast<int>(actualPeriod);
+    ringFrames = static_cast<int>(actualBuffer);
+
     std::cout << "[ALSA] Period size: " << actualPeriod
               << " frames, Buffer: " << actualBuffer << " frames ("
-              << periods << " periods), Rate: " << actualRate << " Hz" << std::endl;
+              << periods << " periods), Rate: " << actualRate << " Hz, Format: "
+              << SampleConverter::formatName(converter.getFormat()) << ", Access: "
+              << (mmapActive ? "mmap" : "read/write") << std::endl;
 
     // ---- Software parameters ----
     snd_pcm_sw_params_alloca(&swParams);
@@ -220,28 +285,76 @@ bool AudioOutput::configureAlsa(snd_pcm_t* pcm) {
 
     return true;
 }
-#endif
 
-void AudioOutput::audioLoop() {
-#ifdef HAVE_ALSA
-    // Promote this thread to real-time priority before touching any audio
-    setRealtimePriority();
+long AudioOutput::waitForSpace(snd_pcm_t* pcm) {
+    for (;;) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            return avail;
+        }
+        if (avail >= periodFrames) {
+            return avail;
+        }
+
+        // A prepared stream that never reached its start threshold would
+        // never free space: start it explicitly
+        if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED) {
+            int err = snd_pcm_start(pcm);
+            if (err < 0) {
+                return err;
+            }
+        }
+
+        int err = snd_pcm_wait(pcm, 1000);
+        if (err < 0) {
+            return err;
+        }
+    }
+}
+
+long AudioOutput::renderMmap(snd_pcm_t* pcm, float* floatBuffer, const CaptureBlock* input) {
+    const snd_pcm_channel_area_t* areas = nullptr;
+    snd_pcm_uframes_t offset = 0;
+    snd_pcm_uframes_t frames = static_cast<snd_pcm_uframes_t>(std::min(periodFrames, bufferSize));
+
+    int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+    if (err < 0) {
+        return err;
+    }
 
+    // Interleaved: all channels share one area, channel 0 marks the frame start
+    void* dst = static_cast<char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+
+    engine.process(floatBuffer, static_cast<int>(frames), input);
+    if (recorder) {
+        recorder->pushBlock(floatBuffer, static_cast<int>(frames));
+    }
+    converter.convert(floatBuffer, dst, frames * channels);
+
+    snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+    if (committed >= 0 && static_cast<snd_pcm_uframes_t>(committed) != frames) {
+        return -EPIPE;  // Short commit: treat as an xrun
+    }
+    return committed;
+}
+
+snd_pcm_t* AudioOutput::openPcm(int requestedPeriod, int requestedPeriods) {
     snd_pcm_t* pcm = nullptr;
-    int err;
 
     // Open PCM device
-    err = snd_pcm_open(&pcm, deviceName.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    int err = snd_pcm_open(&pcm, deviceName.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
     if (err < 0) {
         std::cerr << "Cannot open audio device " << deviceName << ": "
                   << snd_strerror(err) << std::endl;
-        running.store(false);
-        return;
+        return nullptr;
     }
 
     // Configure ALSA with explicit period/buffer control
-    if (!configureAlsa(pcm)) {
+    if (!configureAlsa(pcm, requestedPeriod, requestedPeriods)) {
         std::cerr << "[ALSA] Configuration failed, falling back to snd_pcm_set_params" << std::endl;
+        mmapActive = false;
+        periodFrames = bufferSize;
+        converter.setFormat(SampleFormat::S16);
         err = snd_pcm_set_params(pcm,
                                   SND_PCM_FORMAT_S16_LE,
                                   SND_PCM_ACCESS_RW_INTERLEAVED,
@@ -252,22 +365,276 @@ void AudioOutput::audioLoop() {
         if (err < 0) {
             std::cerr << "Cannot set PCM parameters: " << snd_strerror(err) << std::endl;
             snd_pcm_close(pcm);
-            running.store(false);
-            return;
+            return nullptr;
         }
     }
+    return pcm;
+}
 
-    // Allocate buffers
-    std::vector<float> floatBuffer(bufferSize * channels);
-    std::vector<int16_t> intBuffer(bufferSize * channels);
+snd_pcm_t* AudioOutput::reopenPcm(snd_pcm_t* pcm, const LatencyController& latency, const char* reason) {
+    // Period geometry is fixed once hw_params are applied: reopen the
+    // device. The engine keeps its state; the gap is a few milliseconds.
+    LatencyController::Setting setting = latency.current();
+    std::cout << "[Latency] " << reason << ": switching to " << setting.periodFrames
+              << "x" << setting.periods << std::endl;
 
-    // Calculate expected buffer duration for CPU usage estimation
-    double bufferDuration = static_cast<double>(bufferSize) / static_cast<double>(sampleRate);
+    snd_pcm_drop(pcm);
+    snd_pcm_close(pcm);
+    return openPcm(setting.periodFrames, setting.periods);
+}
+
+// ----------------------------------------------------------------------------
+// Full duplex: capture -> effect chain -> playback
+// ----------------------------------------------------------------------------
+
+snd_pcm_t* AudioOutput::openCapture(snd_pcm_t* playback) {
+    const std::string& device = captureDeviceName.empty() ? deviceName : captureDeviceName;
+    snd_pcm_t* capture = nullptr;
+
+    int err = snd_pcm_open(&capture, device.c_str(), SND_PCM_STREAM_CAPTURE, 0);
+    if (err < 0) {
+        std::cerr << "[ALSA] Cannot open capture device " << device << ": " << snd_strerror(err) << std::endl;
+        return nullptr;
+    }
+    if (!configureCapture(capture)) {
+        snd_pcm_close(capture);
+        return nullptr;
+    }
+
+    // Linked streams start, stop and prepare together on one clock
+    err = snd_pcm_link(capture, playback);
+    if (err < 0) {
+        std::cerr << "[ALSA] Cannot link capture to playback (" << snd_strerror(err)
+                  << "): streams start separately and may drift" << std::endl;
+    }
+    return capture;
+}
+
+bool AudioOutput::configureCapture(snd_pcm_t* capture) {
+    int err;
+    snd_pcm_hw_params_t* hwParams = nullptr;
+    snd_pcm_sw_params_t* swParams = nullptr;
+    snd_pcm_hw_params_alloca(&hwParams);
+
+    err = snd_pcm_hw_params_any(capture, hwParams);
+    if (err < 0) {
+        std::cerr << "[ALSA] Cannot get capture hw_params: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+
+    // mmap lets the effect chain read the capture period in place
+    captureMmap = useMmap
+        && snd_pcm_hw_params_set_access(capture, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0;
+    if (!captureMmap && snd_pcm_hw_params_set_access(capture, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED) < 0) {
+        std::cerr << "[ALSA] Cannot set capture access type" << std::endl;
+        return false;
+    }
+
+    static constexpr SampleFormat formatOrder[] = {
+        SampleFormat::S32, SampleFormat::S24, SampleFormat::S16
+    };
+    bool formatSet = false;
+    for (SampleFormat format : formatOrder) {
+        if (snd_pcm_hw_params_test_format(capture, hwParams, toAlsaFormat(format)) == 0
+            && snd_pcm_hw_params_set_format(capture, hwParams, toAlsaFormat(format)) >= 0) {
+            captureFormat = format;
+            formatSet = true;
+            break;
+        }
+    }
+    if (!formatSet) {
+        std::cerr << "[ALSA] Cannot set capture format: no supported sample format" << std::endl;
+        return false;
+    }
+
+    // Same rate and geometry as playback, so one capture period feeds
+    // exactly one rendered period
+    unsigned int rate = static_cast<unsigned int>(sampleRate);
+    snd_pcm_uframes_t period = static_cast<snd_pcm_uframes_t>(periodFrames);
+    snd_pcm_uframes_t ring = static_cast<snd_pcm_uframes_t>(ringFrames);
+    if (snd_pcm_hw_params_set_channels(capture, hwParams, channels) < 0
+        || snd_pcm_hw_params_set_rate(capture, hwParams, rate, 0) < 0
+        || snd_pcm_hw_params_set_period_size_near(capture, hwParams, &period, nullptr) < 0
+        || snd_pcm_hw_params_set_buffer_size_near(capture, hwParams, &ring) < 0) {
+        std::cerr << "[ALSA] Capture device cannot match " << channels << " ch, " << sampleRate
+                  << " Hz, period " << periodFrames << std::endl;
+        return false;
+    }
+
+    err = snd_pcm_hw_params(capture, hwParams);
+    if (err < 0) {
+        std::cerr << "[ALSA] Cannot apply capture hw_params: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+
+    std::cout << "[ALSA] Capture period: " << period << " frames, Buffer: " << ring
+              << " frames, Format: " << SampleConverter::formatName(captureFormat)
+              << ", Access: " << (captureMmap ? "mmap" : "read/write") << std::endl;
+    if (static_cast<int>(period) != periodFrames) {
+        std::cerr << "[ALSA] Warning: capture period differs from playback (" << periodFrames
+                  << "); blocks may be split" << std::endl;
+    }
+
+    // Never auto-start: playback starts the linked pair once prefilled
+    snd_pcm_sw_params_alloca(&swParams);
+    snd_pcm_uframes_t boundary = 0;
+    snd_pcm_sw_params_current(capture, swParams);
+    snd_pcm_sw_params_get_boundary(swParams, &boundary);
+    snd_pcm_sw_params_set_start_threshold(capture, swParams, boundary);
+    snd_pcm_sw_params_set_avail_min(capture, swParams, period);
+    err = snd_pcm_sw_params(capture, swParams);
+    if (err < 0) {
+        std::cerr << "[ALSA] Cannot apply capture sw_params: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AudioOutput::startDuplex(snd_pcm_t* pcm, snd_pcm_t* capture, std::vector<int32_t>& silence) {
+    // Queue all but one period of silence, then start both streams at once:
+    // every capture period then arrives just as one period of playback space
+    // opens, and the input reaches the DAC after the playback ring plus one
+    // capture period
+    snd_pcm_drop(pcm);
+    snd_pcm_drop(capture);
+    if (snd_pcm_prepare(pcm) < 0 || snd_pcm_prepare(capture) < 0) {
+        return false;
+    }
+
+    std::fill(silence.begin(), silence.end(), 0);
+    int remaining = ringFrames - periodFrames;
+    int chunkFrames = static_cast<int>(silence.size()) / channels;
+    while (remaining > 0) {
+        int n = std::min(remaining, chunkFrames);
+        snd_pcm_sframes_t written = mmapActive
+            ? snd_pcm_mmap_writei(pcm, silence.data(), n)
+            : snd_pcm_writei(pcm, silence.data(), n);
+        if (written < 0) {
+            return false;
+        }
+        remaining -= static_cast<int>(written);
+    }
+
+    if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED && snd_pcm_start(pcm) < 0) {
+        return false;
+    }
+    // Not linked (e.g. two different cards): start capture on its own
+    if (snd_pcm_state(capture) == SND_PCM_STATE_PREPARED && snd_pcm_start(capture) < 0) {
+        return false;
+    }
+    return true;
+}
+
+long AudioOutput::beginCapture(snd_pcm_t* capture, int frames, CaptureBlock& block, int32_t* readBuffer) {
+    block.format = captureFormat;
+    block.channels = channels;
+
+    if (!captureMmap) {
+        snd_pcm_sframes_t got = snd_pcm_readi(capture, readBuffer, static_cast<snd_pcm_uframes_t>(frames));
+        if (got < 0) {
+            return got;
+        }
+        block.samples = readBuffer;
+        block.frames = static_cast<int>(got);
+        return got;
+    }
+
+    // Wait for a full capture period, then reference it in place
+    for (;;) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(capture);
+        if (avail < 0) {
+            return avail;
+        }
+        if (avail >= frames) {
+            break;
+        }
+        int err = snd_pcm_wait(capture, 1000);
+        if (err < 0) {
+            return err;
+        }
+    }
+
+    const snd_pcm_channel_area_t* areas = nullptr;
+    snd_pcm_uframes_t offset = 0;
+    snd_pcm_uframes_t count = static_cast<snd_pcm_uframes_t>(frames);
+    int err = snd_pcm_mmap_begin(capture, &areas, &offset, &count);
+    if (err < 0) {
+        return err;
+    }
+    captureOffset = offset;
+    block.samples = static_cast<const char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+    block.frames = static_cast<int>(count);
+    return static_cast<long>(count);
+}
+
+long AudioOutput::endCapture(snd_pcm_t* capture, const CaptureBlock& block) {
+    if (!captureMmap) {
+        return block.frames;
+    }
+    snd_pcm_sframes_t committed = snd_pcm_mmap_commit(capture, captureOffset,
+                                                      static_cast<snd_pcm_uframes_t>(block.frames));
+    if (committed >= 0 && committed != block.frames) {
+        return -EPIPE;
+    }
+    return committed;
+}
+#endif
+
+void AudioOutput::audioLoop() {
+#ifdef HAVE_ALSA
+    // Promote this thread to real-time priority before touching any audio
+    setRealtimePriority();
+
+    // Reopening playback would break the capture link: fixed geometry
+    if (duplex && adaptiveLatency) {
+        std::cerr << "[Latency] Adaptive latency is not available in duplex mode" << std::endl;
+        adaptiveLatency = false;
+    }
+
+    // Adaptive mode starts on the most aggressive setting and backs off
+    LatencyController latency(sampleRate, bufferSize);
+    LatencyController::Setting setting = adaptiveLatency
+        ? latency.current()
+        : LatencyController::Setting{bufferSize, periodCount};
+
+    snd_pcm_t* pcm = openPcm(setting.periodFrames, setting.periods);
+    if (!pcm) {
+        running.store(false);
+        return;
+    }
+
+    // Allocate buffers (pcmBuffer is only used on the read/write path and
+    // is sized for the widest format)
+    std::vector<float> floatBuffer(bufferSize * channels);
+    std::vector<int32_t> pcmBuffer(bufferSize * channels);
+
+    // Frames rendered per wake-up (one period, at most one engine block)
+    int blockFrames = std::min(periodFrames, bufferSize);
+
+    // Full duplex: the capture stream runs on the playback clock
+    snd_pcm_t* capture = nullptr;
+    std::vector<int32_t> captureBuffer;  // Read/write capture only
+    CaptureBlock captureBlock{nullptr, SampleFormat::S16, channels, 0};
+    if (duplex) {
+        capture = openCapture(pcm);
+        if (!capture || !startDuplex(pcm, capture, pcmBuffer)) {
+            std::cerr << "[ALSA] Full-duplex start failed" << std::endl;
+            if (capture) snd_pcm_close(capture);
+            snd_pcm_close(pcm);
+            running.store(false);
+            return;
+        }
+        captureBuffer.resize(bufferSize * channels);
+        std::cout << "[ALSA] Full duplex: line input -> effects, +"
+                  << (1000.0 * periodFrames / sampleRate) << " ms" << std::endl;
+    }
+    double msPerFrame = 1000.0 / static_cast<double>(sampleRate);
 
     // CPU logging variables (logs every 10 seconds)
     float cpuSum = 0.0f;
     float cpuMax = 0.0f;
     int cpuSamples = 0;
+    float headroomMin = 0.0f;
     auto lastLogTime = std::chrono::steady_clock::now();
     const auto logInterval = std::chrono::seconds(10);
 
@@ -275,21 +642,83 @@ void AudioOutput::audioLoop() {
     int consecutiveUnderruns = 0;
 
     while (running.load()) {
-        auto startTime = std::chrono::high_resolution_clock::now();
+        snd_pcm_sframes_t frames;
+
+        // Duplex: block on the capture period first (the linked playback
+        // period completes at the same moment)
+        const CaptureBlock* input = nullptr;
+        if (capture) {
+            long got = beginCapture(capture, blockFrames, captureBlock, captureBuffer.data());
+            if (got < 0) {
+                captureOverruns.fetch_add(1);
+                consecutiveUnderruns++;
+                if (!startDuplex(pcm, capture, pcmBuffer)) {
+                    std::cerr << "[ALSA] Duplex recovery failed" << std::endl;
+                    break;
+                }
+                continue;
+            }
+            input = &captureBlock;
+        }
 
-        // Generate audio
-        engine.process(floatBuffer.data(), bufferSize);
+        // mmap: wait for a period of space first, so the wait does not
+        // count as processing time. The queued audio at wake-up is the
+        // real headroom left inside the ring.
+        float headroomMs = 0.0f;
+        if (mmapActive) {
+            frames = waitForSpace(pcm);
+            if (frames >= 0) {
+                headroomMs = static_cast<float>(std::max<snd_pcm_sframes_t>(0, ringFrames - frames) * msPerFrame);
+            }
+        } else {
+            frames = 0;
+        }
 
-        // Convert to int16
-        for (size_t i = 0; i < floatBuffer.size(); ++i) {
-            float sample = clamp(floatBuffer[i], -1.0f, 1.0f);
-            intBuffer[i] = static_cast<int16_t>(sample * 32767.0f);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto processTime = startTime;
+
+        if (frames >= 0) {
+            if (mmapActive) {
+                // Generate audio straight into the DMA area
+                frames = renderMmap(pcm, floatBuffer.data(), input);
+                processTime = std::chrono::high_resolution_clock::now();
+            } else {
+                // Generate audio
+                engine.process(floatBuffer.data(), blockFrames, input);
+                if (recorder) {
+                    recorder->pushBlock(floatBuffer.data(), blockFrames);
+                }
+
+                // Convert to the negotiated format
+                converter.convert(floatBuffer.data(), pcmBuffer.data(), static_cast<size_t>(blockFrames) * channels);
+
+                processTime = std::chrono::high_resolution_clock::now();
+
+                // Write to ALSA
+                frames = snd_pcm_writei(pcm, pcmBuffer.data(), blockFrames);
+            }
         }
 
-        auto processTime = std::chrono::high_resolution_clock::now();
+        if (capture && frames >= 0 && endCapture(capture, captureBlock) < 0) {
+            captureOverruns.fetch_add(1);
+            consecutiveUnderruns++;
+            if (!startDuplex(pcm, capture, pcmBuffer)) {
+                std::cerr << "[ALSA] Duplex recovery failed" << std::endl;
+                break;
+            }
+            continue;
+        }
 
-        // Write to ALSA
-        snd_pcm_sframes_t frames = snd_pcm_writei(pcm, intBuffer.data(), bufferSize);
+        if (frames < 0 && capture) {
+            // Restart the linked pair from a known fill level
+            underruns.fetch_add(1);
+            consecutiveUnderruns++;
+            if (!startDuplex(pcm, capture, pcmBuffer)) {
+                std::cerr << "[ALSA] Duplex recovery failed" << std::endl;
+                break;
+            }
+            continue;
+        }
 
         if (frames < 0) {
             // Handle underrun — increment counter but avoid blocking I/O here.
@@ -302,24 +731,37 @@ void AudioOutput::audioLoop() {
                 // Recovery failed — this is serious, log it
                 std::cerr << "[ALSA] Recovery failed: " << snd_strerror(static_cast<int>(frames)) << std::endl;
             }
-        } else {
-            // Log after a burst of underruns ends (not during)
-            if (consecutiveUnderruns > 0) {
-                std::cerr << "[ALSA] " << consecutiveUnderruns << " underrun(s) recovered" << std::endl;
-                consecutiveUnderruns = 0;
+            if (adaptiveLatency && latency.recordPeriod(0, 0.0f, true)) {
+                pcm = reopenPcm(pcm, latency, "underrun");
+                if (!pcm) break;
+                blockFrames = std::min(periodFrames, bufferSize);
             }
+            continue;
+        }
+
+        // Log after a burst of underruns ends (not during)
+        if (consecutiveUnderruns > 0) {
+            std::cerr << "[ALSA] " << consecutiveUnderruns << " xrun(s) recovered";
+            if (capture) {
+                std::cerr << " (total: playback " << underruns.load() << ", capture " << captureOverruns.load() << ")";
+            }
+            std::cerr << std::endl;
+            consecutiveUnderruns = 0;
         }
 
         totalBuffers.fetch_add(1);
 
         // Calculate CPU usage (processing time vs available time)
         std::chrono::duration<double> processDuration = processTime - startTime;
-        float cpuUsage = static_cast<float>(processDuration.count() / bufferDuration * 100.0);
+        double blockDuration = static_cast<double>(frames) / static_cast<double>(sampleRate);
+        float cpuUsage = (frames > 0) ? static_cast<float>(processDuration.count() / blockDuration * 100.0) : 0.0f;
         lastCpuUsage.store(cpuUsage);
+        lastHeadroomMs.store(headroomMs);
 
         // Accumulate for logging
         cpuSum += cpuUsage;
         if (cpuUsage > cpuMax) cpuMax = cpuUsage;
+        if (cpuSamples == 0 || headroomMs < headroomMin) headroomMin = headroomMs;
         cpuSamples++;
 
         // Log CPU usage periodically
@@ -327,12 +769,36 @@ void AudioOutput::audioLoop() {
         if (now - lastLogTime >= logInterval && cpuSamples > 0) {
             float avgCpu = cpuSum / cpuSamples;
             std::cout << "[CPU] avg=" << std::fixed << std::setprecision(1) << avgCpu
-                      << "% max=" << cpuMax << "% (headroom: " << (100.0f - cpuMax) << "%)" << std::endl;
+                      << "% max=" << cpuMax << "% (headroom: " << (100.0f - cpuMax) << "%)";
+            if (mmapActive) {
+                std::cout << " queued min=" << headroomMin << "ms";
+            }
+            if (adaptiveLatency) {
+                std::cout << " p99.9=" << (latency.getLoadP999() * 100.0f) << "%";
+            }
+            std::cout << std::endl;
             cpuSum = 0.0f;
             cpuMax = 0.0f;
             cpuSamples = 0;
             lastLogTime = now;
         }
+
+        if (adaptiveLatency && latency.recordPeriod(static_cast<int>(frames), cpuUsage / 100.0f, false)) {
+            pcm = reopenPcm(pcm, latency, "load");
+            if (!pcm) break;
+            blockFrames = std::min(periodFrames, bufferSize);
+        }
+    }
+
+    if (capture) {
+        snd_pcm_unlink(capture);
+        snd_pcm_drop(capture);
+        snd_pcm_close(capture);
+    }
+
+    if (!pcm) {
+        running.store(false);
+        return;
     }
 
     // Drain and close
@@ -345,7 +811,9 @@ AudioOutput::Stats AudioOutput::getStats() const {
     return {
         totalBuffers.load(),
         underruns.load(),
-        lastCpuUsage.load()
+        captureOverruns.load(),
+        lastCpuUsage.load(),
+        lastHeadroomMs.load()
     };
 }
 
@@ -353,11 +821,83 @@ AudioOutput::Stats AudioOutput::getStats() const {
 // SimulatedAudioOutput Implementation
 // ============================================================================
 
-SimulatedAudioOutput::SimulatedAudioOutput(AudioEngine& engine, int bufferSize)
+namespace {
+
+/**
+ * Histogram over fixed microsecond buckets (last bucket is open-ended).
+ */
+struct JitterHistogram {
+    static constexpr int NUM_BUCKETS = 11;
+    static constexpr int64_t BUCKET_LIMITS_US[NUM_BUCKETS - 1] = {
+        10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+    };
+
+    uint64_t counts[NUM_BUCKETS] = {};
+    int64_t maxNs = 0;
+
+    void add(int64_t ns) {
+        int64_t us = ns / 1000;
+        int bucket = 0;
+        while (bucket < NUM_BUCKETS - 1 && us >= BUCKET_LIMITS_US[bucket]) {
+            ++bucket;
+        }
+        ++counts[bucket];
+        maxNs = std::max(maxNs, ns);
+    }
+
+    void print(const char* title) const {
+        uint64_t total = 0;
+        for (uint64_t count : counts) total += count;
+        if (total == 0) return;
+
+        std::cout << "  " << title << " (max " << std::fixed << std::setprecision(1)
+                  << maxNs / 1000.0 << " us):" << std::endl;
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            if (counts[bucket] == 0) continue;
+            std::cout << "    ";
+            if (bucket < NUM_BUCKETS - 1) {
+                std::cout << "< " << std::setw(5) << BUCKET_LIMITS_US[bucket] << " us: ";
+            } else {
+                std::cout << ">=" << std::setw(5) << BUCKET_LIMITS_US[bucket - 1] << " us: ";
+            }
+            std::cout << std::setw(10) << counts[bucket] << "  ("
+                      << std::setprecision(3) << (100.0 * counts[bucket] / total) << "%)"
+                      << std::setprecision(1) << std::endl;
+        }
+        std::cout << std::defaultfloat;
+    }
+};
+
+constexpr int64_t JitterHistogram::BUCKET_LIMITS_US[];
+
+/**
+ * Sleep until an absolute CLOCK_MONOTONIC time (monotonicNanos() clock).
+ */
+void sleepUntilNanos(int64_t deadlineNs) {
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadlineNs)));
+#endif
+}
+
+} // anonymous namespace
+
+SimulatedAudioOutput::SimulatedAudioOutput(AudioEngine& engine, int sampleRate, int bufferSize)
     : engine(engine)
+    , sampleRate(sampleRate)
     , bufferSize(bufferSize)
+    , realtime(false)
+    , recorder(nullptr)
     , running(false)
     , buffer(bufferSize * 2)  // Stereo
+    , totalBuffers(0)
+    , virtualUnderruns(0)
+    , maxWakeLatencyUs(0.0f)
 {
     std::cout << "Running in SIMULATION mode (no audio output)" << std::endl;
 }
@@ -374,7 +914,8 @@ bool SimulatedAudioOutput::start() {
     running.store(true);
     simulationThread = std::thread(&SimulatedAudioOutput::simulationLoop, this);
     
-    std::cout << "Simulated audio output started" << std::endl;
+    std::cout << "Simulated audio output started: " << sampleRate << "Hz, "
+              << bufferSize << " samples/block" << std::endl;
     return true;
 }
 
@@ -392,18 +933,68 @@ void SimulatedAudioOutput::stop() {
     std::cout << "Simulated audio output stopped" << std::endl;
 }
 
+SimulatedAudioOutput::Stats SimulatedAudioOutput::getStats() const {
+    return {
+        totalBuffers.load(),
+        virtualUnderruns.load(),
+        maxWakeLatencyUs.load()
+    };
+}
+
 void SimulatedAudioOutput::simulationLoop() {
-    // Simulate audio callback at regular intervals
-    double bufferDuration = static_cast<double>(bufferSize) / static_cast<double>(DEFAULT_SAMPLE_RATE);
-    auto sleepDuration = std::chrono::duration<double>(bufferDuration);
-    
+    bool isRealtime = realtime && promoteThreadToRealtime();
+
+    JitterHistogram wakeLatency;    // Wake-up time - deadline
+    JitterHistogram processingTime; // engine.process() duration
+
+    // Deadlines are derived from the frame count, not accumulated, so
+    // rounding never drifts the clock
+    int64_t startNs = monotonicNanos();
+    uint64_t framesDone = 0;
+    uint64_t blocks = 0;
+    uint64_t misses = 0;
+    int64_t blockNs = static_cast<int64_t>(bufferSize) * 1000000000LL / sampleRate;
+    auto deadlineFor = [&](uint64_t frames) {
+        return startNs + static_cast<int64_t>(frames * 1000000000ULL / static_cast<uint64_t>(sampleRate));
+    };
+
     while (running.load()) {
-        // Generate audio (but don't output it)
+        int64_t processStartNs = monotonicNanos();
         engine.process(buffer.data(), bufferSize);
-        
-        // Sleep to simulate real-time behavior
-        std::this_thread::sleep_for(sleepDuration);
+        if (recorder) {
+            recorder->pushBlock(buffer.data(), bufferSize);
+        }
+        int64_t processEndNs = monotonicNanos();
+        processingTime.add(processEndNs - processStartNs);
+
+        framesDone += static_cast<uint64_t>(bufferSize);
+        totalBuffers.store(++blocks);
+
+        // Rendering started at the previous deadline; the block has to be
+        // ready before the one before it finishes playing. A miss restarts
+        // the clock from here, like a PCM recovering with prepare
+        int64_t deadlineNs = deadlineFor(framesDone);
+        if (processEndNs > deadlineNs) {
+            virtualUnderruns.store(++misses);
+            startNs = processEndNs;
+            framesDone = 0;
+            continue;
+        }
+
+        sleepUntilNanos(deadlineNs);
+        int64_t lateNs = std::max<int64_t>(0, monotonicNanos() - deadlineNs);
+        wakeLatency.add(lateNs);
+        maxWakeLatencyUs.store(wakeLatency.maxNs / 1000.0f);
     }
+
+    double seconds = static_cast<double>(blocks) * bufferSize / sampleRate;
+    std::cout << "\nSimulated audio clock (" << std::fixed << std::setprecision(1) << seconds
+              << " s, " << (isRealtime ? "real-time priority" : "normal priority") << "):" << std::endl;
+    std::cout << "  Blocks: " << blocks << ", virtual underruns: " << misses
+              << " (block period " << blockNs / 1000.0 << " us)" << std::endl;
+    std::cout << std::defaultfloat;
+    wakeLatency.print("Wake-up latency");
+    processingTime.print("Processing time");
 }
 
 } // namespace DubSiren
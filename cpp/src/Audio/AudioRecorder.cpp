@@ -0,0 +1,328 @@
+#include "Audio/AudioRecorder.h"
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace DubSiren {
+
+namespace {
+
+constexpr uint32_t RIFF_SIZE_LIMIT = 0xFFFFFFFFu;  // Larger files become RF64
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+
+void put16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void put64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+// pwrite() the whole range, retrying short writes
+bool writeFully(int fd, const void* data, size_t bytes, uint64_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+std::string resolveRecordingPath(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return path;
+    }
+
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    std::strftime(name, sizeof(name), "dubsiren-%Y%m%d-%H%M%S.wav", &local);
+
+    std::string dir = path;
+    if (!dir.empty() && dir.back() != '/') dir += '/';
+    return dir + name;
+}
+
+} // anonymous namespace
+
+AudioRecorder::AudioRecorder(int sampleRate, int channels)
+    : sampleRate(sampleRate)
+    , channels(channels)
+    , fd(-1)
+    , ringMask(0)
+    , writePos(0)
+    , readPos(0)
+    , chunk(nullptr)
+    , chunkSamples(WRITE_CHUNK_BYTES / sizeof(float))
+    , recording(false)
+    , writerRunning(false)
+    , framesWritten(0)
+    , droppedBlocks(0)
+    , droppedFrames(0)
+    , dataBytes(0)
+{
+}
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+    std::free(chunk);
+}
+
+bool AudioRecorder::start(const std::string& path) {
+    if (writerThread.joinable()) {
+        return true;
+    }
+
+    // Buffers are allocated and touched here, never on the audio thread
+    if (!ring) {
+        size_t ringSize = 1;
+        while (ringSize < static_cast<size_t>(RING_SECONDS * sampleRate * channels)) {
+            ringSize <<= 1;
+        }
+        ring.reset(new float[ringSize]());
+        ringMask = ringSize - 1;
+    }
+    if (!chunk) {
+        void* mem = nullptr;
+        if (posix_memalign(&mem, DATA_OFFSET, WRITE_CHUNK_BYTES) != 0) {
+            std::cerr << "[Recorder] Cannot allocate write buffer" << std::endl;
+            return false;
+        }
+        chunk = static_cast<float*>(mem);
+        std::memset(chunk, 0, WRITE_CHUNK_BYTES);
+    }
+
+    filePath = resolveRecordingPath(path);
+    fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Recorder] Cannot create " << filePath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    dataBytes = 0;
+    framesWritten.store(0);
+    droppedBlocks.store(0);
+    droppedFrames.store(0);
+    writePos.store(0);
+    readPos.store(0);
+
+    if (!writeHeader()) {
+        std::cerr << "[Recorder] Cannot write " << filePath << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    writerRunning.store(true);
+    recording.store(true, std::memory_order_release);
+    writerThread = std::thread(&AudioRecorder::writerLoop, this);
+
+    std::cout << "[Recorder] Recording to " << filePath << " (" << sampleRate << " Hz, "
+              << channels << " ch, 32-bit float)" << std::endl;
+    return true;
+}
+
+void AudioRecorder::stop() {
+    if (!writerThread.joinable()) {
+        return;
+    }
+
+    recording.store(false, std::memory_order_release);
+    writerRunning.store(false);
+    writerThread.join();
+
+    Stats stats = getStats();
+    std::cout << "[Recorder] Wrote " << std::fixed << std::setprecision(1)
+              << static_cast<double>(stats.framesWritten) / sampleRate << " s to " << filePath
+              << std::defaultfloat;
+    if (stats.droppedBlocks > 0) {
+        std::cout << " (" << stats.droppedBlocks << " blocks / " << stats.droppedFrames
+                  << " frames dropped: storage too slow)";
+    }
+    std::cout << std::endl;
+}
+
+AudioRecorder::Stats AudioRecorder::getStats() const {
+    return {
+        framesWritten.load(),
+        droppedBlocks.load(),
+        droppedFrames.load()
+    };
+}
+
+void AudioRecorder::pushBlock(const float* interleaved, int numFrames) {
+    if (!recording.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    size_t samples = static_cast<size_t>(numFrames) * channels;
+    size_t head = writePos.load(std::memory_order_relaxed);
+    size_t used = head - readPos.load(std::memory_order_acquire);
+    if (ringMask + 1 - used < samples) {
+        // Storage is behind: drop the whole block, never wait
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        droppedFrames.fetch_add(static_cast<uint64_t>(numFrames), std::memory_order_relaxed);
+        return;
+    }
+
+    size_t start = head & ringMask;
+    size_t first = std::min(samples, ringMask + 1 - start);
+    std::memcpy(&ring[start], interleaved, first * sizeof(float));
+    std::memcpy(&ring[0], interleaved + first, (samples - first) * sizeof(float));
+    writePos.store(head + samples, std::memory_order_release);
+}
+
+size_t AudioRecorder::drainRing(size_t filled) {
+    size_t tail = readPos.load(std::memory_order_relaxed);
+    size_t available = writePos.load(std::memory_order_acquire) - tail;
+    size_t samples = std::min(available, chunkSamples - filled);
+    if (samples == 0) {
+        return 0;
+    }
+
+    size_t start = tail & ringMask;
+    size_t first = std::min(samples, ringMask + 1 - start);
+    std::memcpy(chunk + filled, &ring[start], first * sizeof(float));
+    std::memcpy(chunk + filled + first, &ring[0], (samples - first) * sizeof(float));
+    readPos.store(tail + samples, std::memory_order_release);
+    return samples;
+}
+
+bool AudioRecorder::writeChunk(size_t samples) {
+    size_t bytes = samples * sizeof(float);
+    if (!writeFully(fd, chunk, bytes, DATA_OFFSET + dataBytes)) {
+        return false;
+    }
+    dataBytes += bytes;
+    framesWritten.store(dataBytes / (sizeof(float) * channels));
+    return true;
+}
+
+bool AudioRecorder::writeHeader() {
+    // RIFF/RF64 | ds64 or JUNK (28) | fmt (16) | fact (4) | JUNK pad | data
+    // Audio data starts at DATA_OFFSET so chunk writes stay page aligned
+    uint8_t header[DATA_OFFSET] = {};
+    uint64_t riffSize = DATA_OFFSET - 8 + dataBytes;
+    uint64_t frames = dataBytes / (sizeof(float) * channels);
+    bool rf64 = riffSize > RIFF_SIZE_LIMIT;
+
+    std::memcpy(header + 0, rf64 ? "RF64" : "RIFF", 4);
+    put32(header + 4, rf64 ? RIFF_SIZE_LIMIT : static_cast<uint32_t>(riffSize));
+    std::memcpy(header + 8, "WAVE", 4);
+
+    // Reserved for the ds64 chunk until the file needs it
+    std::memcpy(header + 12, rf64 ? "ds64" : "JUNK", 4);
+    put32(header + 16, 28);
+    if (rf64) {
+        put64(header + 20, riffSize);
+        put64(header + 28, dataBytes);
+        put64(header + 36, frames);
+        put32(header + 44, 0);  // No table entries
+    }
+
+    std::memcpy(header + 48, "fmt ", 4);
+    put32(header + 52, 16);
+    put16(header + 56, WAVE_FORMAT_IEEE_FLOAT);
+    put16(header + 58, static_cast<uint16_t>(channels));
+    put32(header + 60, static_cast<uint32_t>(sampleRate));
+    put32(header + 64, static_cast<uint32_t>(sampleRate * channels * sizeof(float)));
+    put16(header + 68, static_cast<uint16_t>(channels * sizeof(float)));
+    put16(header + 70, 32);
+
+    std::memcpy(header + 72, "fact", 4);
+    put32(header + 76, 4);
+    put32(header + 80, rf64 ? RIFF_SIZE_LIMIT : static_cast<uint32_t>(frames));
+
+    std::memcpy(header + 84, "JUNK", 4);
+    put32(header + 88, static_cast<uint32_t>(DATA_OFFSET - 8 - 92));
+
+    std::memcpy(header + DATA_OFFSET - 8, "data", 4);
+    put32(header + DATA_OFFSET - 4, rf64 ? RIFF_SIZE_LIMIT : static_cast<uint32_t>(dataBytes));
+
+    return writeFully(fd, header, sizeof(header), 0);
+}
+
+void AudioRecorder::writerLoop() {
+#ifdef __linux__
+    // Below the UI threads: recording may fall behind, controls may not
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+
+    size_t filled = 0;
+    uint64_t headerBytes = 0;
+    uint64_t reportedDrops = 0;
+    uint64_t headerInterval = static_cast<uint64_t>(HEADER_UPDATE_SECONDS * sampleRate) * channels * sizeof(float);
+    bool ok = true;
+
+    // Keep going after stop() until the ring is empty
+    while (ok) {
+        size_t moved = drainRing(filled);
+        filled += moved;
+
+        if (filled == chunkSamples) {
+            ok = writeChunk(filled);
+            filled = 0;
+        }
+
+        if (ok && dataBytes - headerBytes >= headerInterval) {
+            ok = writeHeader();
+            headerBytes = dataBytes;
+        }
+
+        uint64_t drops = droppedBlocks.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            std::cerr << "[Recorder] Storage stalled: " << drops << " blocks dropped so far" << std::endl;
+            reportedDrops = drops;
+        }
+
+        if (moved == 0) {
+            if (!writerRunning.load()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    if (ok && filled > 0) {
+        ok = writeChunk(filled);
+    }
+    if (ok) {
+        ok = writeHeader();
+    }
+    if (!ok) {
+        std::cerr << "[Recorder] Write to " << filePath << " failed: " << std::strerror(errno)
+                  << " - recording stopped" << std::endl;
+        recording.store(false, std::memory_order_release);
+        writeHeader();  // Best effort: keep what made it to disk playable
+    }
+
+    fsync(fd);
+    close(fd);
+    fd = -1;
+}
+
+} // namespace DubSiren
@@ -0,0 +1,94 @@
+#include "Audio/LatencyController.h"
+
+namespace DubSiren {
+
+constexpr LatencyController::Setting LatencyController::LADDER[];
+
+LatencyController::LatencyController(int sampleRate, int maxPeriodFrames)
+    : sampleRate(std::max(1, sampleRate))
+    , topRung(0)
+    , rung(0)
+    , holdFailures{}
+    , histogram{}
+    , windowPeriods(0)
+    , windowFrames(0)
+    , stableFrames(0)
+    , lastWindowP999(0.0f)
+{
+    while (topRung + 1 < NUM_RUNGS && LADDER[topRung + 1].periodFrames <= maxPeriodFrames) {
+        ++topRung;
+    }
+}
+
+bool LatencyController::recordPeriod(int frames, float load, bool underrun) {
+    if (underrun) {
+        ++holdFailures[rung];
+        return moveTo(rung + 1);
+    }
+
+    int bin = static_cast<int>(load * (HISTOGRAM_BINS / 2.0f));
+    histogram[std::min(HISTOGRAM_BINS - 1, std::max(0, bin))]++;
+    ++windowPeriods;
+    windowFrames += frames;
+
+    if (windowFrames < static_cast<int64_t>(WINDOW_SECONDS * sampleRate)) {
+        return false;
+    }
+
+    // Window complete
+    lastWindowP999 = windowP999();
+    resetWindow();
+
+    if (lastWindowP999 > STEP_UP_LOAD) {
+        ++holdFailures[rung];
+        return moveTo(rung + 1);
+    }
+
+    // Only an unbroken run of quiet windows counts towards stepping down
+    if (lastWindowP999 >= STEP_DOWN_LOAD) {
+        stableFrames = 0;
+        return false;
+    }
+    stableFrames += static_cast<int64_t>(WINDOW_SECONDS * sampleRate);
+
+    if (rung > 0) {
+        // Hold time doubles with every failure of the rung below
+        float hold = BASE_HOLD_SECONDS * static_cast<float>(1 << std::min(holdFailures[rung - 1], 6));
+        if (stableFrames >= static_cast<int64_t>(hold * sampleRate)) {
+            return moveTo(rung - 1);
+        }
+    }
+    return false;
+}
+
+bool LatencyController::moveTo(int newRung) {
+    newRung = std::min(topRung, std::max(0, newRung));
+    resetWindow();
+    stableFrames = 0;
+    if (newRung == rung) {
+        return false;
+    }
+    rung = newRung;
+    return true;
+}
+
+float LatencyController::windowP999() const {
+    // Walk down from the top until more than 0.1% of periods are covered
+    uint32_t limit = windowPeriods / 1000;
+    uint32_t count = 0;
+    for (int bin = HISTOGRAM_BINS - 1; bin >= 0; --bin) {
+        count += histogram[bin];
+        if (count > limit) {
+            return static_cast<float>(bin + 1) * (2.0f / HISTOGRAM_BINS);
+        }
+    }
+    return 0.0f;
+}
+
+void LatencyController::resetWindow() {
+    std::fill(histogram, histogram + HISTOGRAM_BINS, 0u);
+    windowPeriods = 0;
+    windowFrames = 0;
+}
+
+} // namespace DubSiren
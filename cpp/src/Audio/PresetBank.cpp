@@ -0,0 +1,168 @@
+#include "Audio/PresetBank.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace DubSiren {
+
+namespace {
+
+struct BankHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BankHeader) == 16, "Bank header layout is part of the file format");
+
+constexpr char BANK_MAGIC[4] = {'D', 'S', 'P', 'B'};
+constexpr uint16_t BANK_VERSION = 2;
+
+constexpr uint8_t NJD = static_cast<uint8_t>(PresetGroup::NJD);
+constexpr uint8_t UFO = static_cast<uint8_t>(PresetGroup::UFO);
+constexpr uint8_t PITCH = Preset::HAS_LFO_PITCH_DEPTH;
+constexpr uint8_t WAIL = Preset::HAS_LFO_RATE | Preset::HAS_LFO_PITCH_DEPTH;
+constexpr uint8_t LFO_ALL = WAIL | Preset::HAS_LFO_DEPTH;
+constexpr uint8_t TRI = static_cast<uint8_t>(Waveform::Triangle);
+
+// Built-in bank
+// name, group, flags, osc, lfo wave, freq, release, delay time, delay fb,
+// reverb size, reverb mix, lfo rate, lfo depth, lfo pitch depth
+const Preset DEFAULT_PRESETS[] = {
+    // NJD classic dub siren presets (LFO pitch depth only; the filter LFO is left as it is)
+    {"Auto Wail",     NJD, WAIL,                   1, TRI, 440.0f,  0.5f,  0.375f, 0.55f, 0.7f,  0.4f,  0.35f, 0.5f, 0.5f},
+    {"Classic",       NJD, PITCH,                  1, 0,   587.0f,  0.8f,  0.375f, 0.5f,  0.65f, 0.35f, 0.0f,  0.0f, 0.0f},
+    {"Alert",         NJD, PITCH,                  1, 0,   440.0f,  0.3f,  0.375f, 0.55f, 0.7f,  0.4f,  0.0f,  0.0f, 0.0f},
+    {"Bright",        NJD, PITCH,                  1, 0,   880.0f,  0.5f,  0.25f,  0.55f, 0.4f,  0.35f, 0.0f,  0.0f, 0.0f},
+    {"Wobble",        NJD, PITCH,                  2, 0,   392.0f,  1.0f,  0.333f, 0.6f,  0.5f,  0.4f,  0.0f,  0.0f, 0.0f},
+
+    // UFO sci-fi presets (leave the LFO as it is)
+    {"Laser Blast",   UFO, 0,                      1, 0,   1600.0f, 0.15f, 0.03f,  0.4f,  0.2f,  0.15f, 0.0f,  0.0f, 0.0f},
+    {"Flying Saucer", UFO, 0,                      0, 0,   1200.0f, 2.0f,  0.1f,   0.7f,  0.9f,  0.5f,  0.0f,  0.0f, 0.0f},
+    {"Alien Signal",  UFO, 0,                      1, 0,   1800.0f, 0.3f,  0.05f,  0.8f,  0.3f,  0.6f,  0.0f,  0.0f, 0.0f},
+    {"Warp Drive",    UFO, 0,                      2, 0,   80.0f,   3.0f,  0.75f,  0.5f,  0.95f, 0.45f, 0.0f,  0.0f, 0.0f},
+};
+
+// Auto Wail at a 2 Hz wee-woo, as normal mode starts
+const Preset NORMAL_MODE_PRESET =
+    {"Normal",        NJD, LFO_ALL,                1, TRI, 440.0f,  0.5f,  0.375f, 0.55f, 0.7f,  0.4f,  2.0f,  0.5f, 0.5f};
+
+} // namespace
+
+PresetBank::PresetBank()
+    : presets(DEFAULT_PRESETS)
+    , numPresets(static_cast<int>(sizeof(DEFAULT_PRESETS) / sizeof(DEFAULT_PRESETS[0])))
+    , mapping(nullptr)
+    , mappingSize(0)
+{
+}
+
+PresetBank::~PresetBank() {
+    unmap();
+}
+
+void PresetBank::unmap() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+}
+
+bool PresetBank::loadFromFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Presets] Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BankHeader)) {
+        std::cerr << "[Presets] " << path << " is too small to be a preset bank" << std::endl;
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Presets] mmap failed for " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const BankHeader* header = static_cast<const BankHeader*>(base);
+    size_t needed = sizeof(BankHeader) + static_cast<size_t>(header->count) * sizeof(Preset);
+    if (std::memcmp(header->magic, BANK_MAGIC, sizeof(BANK_MAGIC)) != 0
+        || header->recordSize != sizeof(Preset)
+        || size < needed) {
+        std::cerr << "[Presets] " << path << " is not a valid preset bank" << std::endl;
+        munmap(base, size);
+        return false;
+    }
+    if (header->version != BANK_VERSION) {
+        std::cerr << "[Presets] " << path << " is a version " << header->version << " bank (expected "
+                  << BANK_VERSION << "); write a new one with --save-presets" << std::endl;
+        munmap(base, size);
+        return false;
+    }
+
+    unmap();
+    mapping = base;
+    mappingSize = size;
+    presets = reinterpret_cast<const Preset*>(static_cast<const char*>(base) + sizeof(BankHeader));
+    numPresets = header->count;
+
+    std::cout << "[Presets] Loaded " << numPresets << " preset(s) from " << path << std::endl;
+    return true;
+}
+
+bool PresetBank::saveToFile(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "[Presets] Cannot write " << path << std::endl;
+        return false;
+    }
+
+    BankHeader header{};
+    std::memcpy(header.magic, BANK_MAGIC, sizeof(BANK_MAGIC));
+    header.version = BANK_VERSION;
+    header.count = static_cast<uint16_t>(numPresets);
+    header.recordSize = sizeof(Preset);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(presets), static_cast<std::streamsize>(numPresets * sizeof(Preset)));
+    return static_cast<bool>(file);
+}
+
+int PresetBank::count(PresetGroup group) const {
+    int n = 0;
+    for (int i = 0; i < numPresets; ++i) {
+        if (presets[i].group == static_cast<uint8_t>(group)) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+const Preset* PresetBank::find(PresetGroup group, int index) const {
+    for (int i = 0; i < numPresets; ++i) {
+        if (presets[i].group == static_cast<uint8_t>(group) && index-- == 0) {
+            return &presets[i];
+        }
+    }
+    return nullptr;
+}
+
+const Preset& PresetBank::normalMode() {
+    return NORMAL_MODE_PRESET;
+}
+
+} // namespace DubSiren
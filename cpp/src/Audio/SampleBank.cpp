@@ -0,0 +1,211 @@
+#include "Audio/SampleBank.h"
+#include "Audio/SampleConverter.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace DubSiren {
+
+namespace {
+
+struct BankHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t sampleRate;
+    uint16_t format;
+    uint16_t channels;
+};
+
+static_assert(sizeof(BankHeader) == 16, "Bank header layout is part of the file format");
+
+constexpr char BANK_MAGIC[4] = {'D', 'S', 'S', 'B'};
+constexpr uint16_t BANK_VERSION = 1;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// With mlockall(MCL_FUTURE) in force a plain mmap() reads in and pins the
+// whole file. A PROT_NONE mapping is not populated; dropping the lock
+// before opening it up leaves the pages to be faulted in on demand.
+void* mapUnlocked(int fd, size_t size) {
+    void* base = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    munlock(base, size);
+    if (mprotect(base, size, PROT_READ) != 0) {
+        munmap(base, size);
+        return MAP_FAILED;
+    }
+    return base;
+}
+
+} // namespace
+
+SampleBank::SampleBank()
+    : entries(nullptr)
+    , numEntries(0)
+    , format(FORMAT_S16)
+    , mapping(nullptr)
+    , mappingSize(0)
+{
+}
+
+SampleBank::~SampleBank() {
+    unmap();
+}
+
+void SampleBank::unmap() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    entries = nullptr;
+    numEntries = 0;
+}
+
+bool SampleBank::load(const std::string& path) {
+    unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Bank] Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BankHeader)) {
+        std::cerr << "[Bank] " << path << " is too small to be a sample bank" << std::endl;
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mapUnlocked(fd, size);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Bank] mmap failed for " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const BankHeader* header = static_cast<const BankHeader*>(base);
+    size_t tableEnd = sizeof(BankHeader) + static_cast<size_t>(header->count) * sizeof(SampleBankEntry);
+    bool valid = std::memcmp(header->magic, BANK_MAGIC, sizeof(BANK_MAGIC)) == 0
+        && header->version == BANK_VERSION
+        && header->sampleRate == SAMPLE_RATE
+        && header->channels == CHANNELS
+        && (header->format == FORMAT_S16 || header->format == FORMAT_FLOAT)
+        && size >= tableEnd;
+
+    // Every entry's data must lie inside the file
+    const SampleBankEntry* table = reinterpret_cast<const SampleBankEntry*>(
+        static_cast<const char*>(base) + sizeof(BankHeader));
+    size_t frameBytes = CHANNELS * (header->format == FORMAT_S16 ? sizeof(int16_t) : sizeof(float));
+    for (int i = 0; valid && i < header->count; ++i) {
+        valid = table[i].offset % DATA_ALIGNMENT == 0
+            && table[i].offset >= tableEnd
+            && table[i].offset <= size
+            && table[i].frames <= (size - table[i].offset) / frameBytes;
+    }
+
+    if (!valid) {
+        std::cerr << "[Bank] " << path << " is not a valid sample bank" << std::endl;
+        munmap(base, size);
+        return false;
+    }
+
+    mapping = base;
+    mappingSize = size;
+    entries = table;
+    numEntries = header->count;
+    format = header->format;
+    return true;
+}
+
+bool SampleBank::write(const std::string& path, const std::vector<Source>& sources, uint16_t format) {
+    if (sources.size() > UINT16_MAX || (format != FORMAT_S16 && format != FORMAT_FLOAT)) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "[Bank] Cannot write " << path << std::endl;
+        return false;
+    }
+
+    size_t frameBytes = CHANNELS * (format == FORMAT_S16 ? sizeof(int16_t) : sizeof(float));
+
+    BankHeader header{};
+    std::memcpy(header.magic, BANK_MAGIC, sizeof(BANK_MAGIC));
+    header.version = BANK_VERSION;
+    header.count = static_cast<uint16_t>(sources.size());
+    header.sampleRate = SAMPLE_RATE;
+    header.format = format;
+    header.channels = CHANNELS;
+
+    std::vector<SampleBankEntry> table(sources.size());
+    size_t offset = alignUp(sizeof(BankHeader) + table.size() * sizeof(SampleBankEntry), DATA_ALIGNMENT);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        SampleBankEntry& entry = table[i];
+        std::memset(&entry, 0, sizeof(entry));
+        std::strncpy(entry.name, sources[i].name.c_str(), sizeof(entry.name) - 1);
+        std::memcpy(entry.color, sources[i].color, sizeof(entry.color));
+        entry.offset = offset;
+        entry.frames = sources[i].samples.size() / CHANNELS;
+        offset = alignUp(offset + entry.frames * frameBytes, DATA_ALIGNMENT);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()),
+               static_cast<std::streamsize>(table.size() * sizeof(SampleBankEntry)));
+
+    SampleConverter converter(SampleFormat::S16);
+    std::vector<int16_t> pcm;
+    for (size_t i = 0; i < sources.size() && file; ++i) {
+        file.seekp(static_cast<std::streamoff>(table[i].offset));
+        const std::vector<float>& samples = sources[i].samples;
+        size_t count = table[i].frames * CHANNELS;
+        if (format == FORMAT_S16) {
+            // TPDF dithered, like the 16-bit output path
+            pcm.resize(count);
+            converter.convert(samples.data(), pcm.data(), count);
+            file.write(reinterpret_cast<const char*>(pcm.data()), static_cast<std::streamsize>(count * sizeof(int16_t)));
+        } else {
+            file.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(count * sizeof(float)));
+        }
+    }
+
+    // Pad the last sample out to a whole page
+    if (file && !table.empty()) {
+        const SampleBankEntry& last = table.back();
+        size_t end = alignUp(last.offset + last.frames * frameBytes, DATA_ALIGNMENT);
+        size_t written = last.offset + last.frames * frameBytes;
+        if (end > written) {
+            std::vector<char> pad(end - written, 0);
+            file.write(pad.data(), static_cast<std::streamsize>(pad.size()));
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+const SampleBankEntry* SampleBank::entry(int index) const {
+    if (index < 0 || index >= numEntries) {
+        return nullptr;
+    }
+    return &entries[index];
+}
+
+const void* SampleBank::data(const SampleBankEntry& entry) const {
+    return static_cast<const char*>(mapping) + entry.offset;
+}
+
+} // namespace DubSiren
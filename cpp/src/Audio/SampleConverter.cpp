@@ -0,0 +1,151 @@
+#include "Audio/SampleConverter.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace DubSiren {
+
+SampleConverter::SampleConverter(SampleFormat format)
+    : format(format)
+    , rngState{0x9E3779B9u, 0x7F4A7C15u, 0x94D049BBu, 0x2545F491u}  // Any non-zero seeds
+{
+}
+
+const char* SampleConverter::formatName(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::S16: return "S16_LE";
+        case SampleFormat::S24: return "S24_LE";
+        case SampleFormat::S32: return "S32_LE";
+    }
+    return "unknown";
+}
+
+// Scale float to a signed integer range without branches
+static inline int32_t toFixed(float sample, float scale) {
+    sample = std::min(1.0f, std::max(-1.0f, sample));
+    return static_cast<int32_t>(sample * scale);
+}
+
+void SampleConverter::convert(const float* input, void* output, size_t count) {
+    switch (format) {
+        case SampleFormat::S16:
+            convertS16(input, static_cast<int16_t*>(output), count);
+            break;
+
+        case SampleFormat::S24: {
+            int32_t* out = static_cast<int32_t*>(output);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = toFixed(input[i], 8388607.0f);
+            }
+            break;
+        }
+
+        case SampleFormat::S32: {
+            // float carries 24 bits of mantissa; place them at the top
+            int32_t* out = static_cast<int32_t*>(output);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = static_cast<int32_t>(static_cast<uint32_t>(toFixed(input[i], 8388607.0f)) << 8);
+            }
+            break;
+        }
+    }
+}
+
+// Sum the channels of each frame (container T, Shift sign-extends packed
+// 24-bit values) and accumulate the scaled result into output
+template<typename T, int Shift>
+static void mixFrames(const T* in, int channels, float scale, float* output, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            int32_t value = static_cast<int32_t>(static_cast<uint32_t>(in[ch]) << Shift) >> Shift;
+            sum += static_cast<float>(value);
+        }
+        output[i] += sum * scale;
+        in += channels;
+    }
+}
+
+void SampleConverter::mixToMono(const void* input, SampleFormat format, int channels,
+                                float gain, float* output, size_t frames) {
+    float perChannel = gain / static_cast<float>(std::max(1, channels));
+    switch (format) {
+        case SampleFormat::S16:
+            mixFrames<int16_t, 0>(static_cast<const int16_t*>(input), channels,
+                                  perChannel / 32768.0f, output, frames);
+            break;
+        case SampleFormat::S24:
+            mixFrames<int32_t, 8>(static_cast<const int32_t*>(input), channels,
+                                  perChannel / 8388608.0f, output, frames);
+            break;
+        case SampleFormat::S32:
+            mixFrames<int32_t, 0>(static_cast<const int32_t*>(input), channels,
+                                  perChannel / 2147483648.0f, output, frames);
+            break;
+    }
+}
+
+void SampleConverter::toFloat(const int16_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    // Widen to 32 bits, then convert as fixed point with 15 fraction bits
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t pcm = vld1q_s16(input + i);
+        vst1q_f32(output + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(pcm)), 15));
+        vst1q_f32(output + i + 4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(pcm)), 15));
+    }
+#endif
+    // Remainder on NEON; the whole buffer elsewhere (auto-vectorized)
+    for (; i < count; ++i) {
+        output[i] = static_cast<float>(input[i]) * (1.0f / 32768.0f);
+    }
+}
+
+void SampleConverter::roundToS16(const float* input, int16_t* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int32_t value = static_cast<int32_t>(input[i] * 32768.0f + 32768.5f) - 32768;
+        output[i] = static_cast<int16_t>(std::min(32767, std::max(-32768, value)));
+    }
+}
+
+void SampleConverter::convertS16(const float* input, int16_t* output, size_t count) {
+    constexpr float SCALE = 32767.0f;
+    constexpr float UNIFORM = 1.0f / 65536.0f;
+
+    uint32_t state[LANES];
+    std::copy(rngState, rngState + LANES, state);
+
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        // Lanes are independent: the compiler maps this onto one vector
+        for (int lane = 0; lane < LANES; ++lane) {
+            // xorshift32
+            uint32_t x = state[lane];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state[lane] = x;
+
+            // Two 16-bit uniforms from one draw; their difference is TPDF in (-1, 1) LSB
+            float tpdf = (static_cast<float>(static_cast<int32_t>(x & 0xFFFF))
+                          - static_cast<float>(static_cast<int32_t>(x >> 16))) * UNIFORM;
+
+            float scaled = std::min(1.0f, std::max(-1.0f, input[i + lane])) * SCALE + tpdf;
+
+            // Round to nearest (offset keeps the cast's truncation a floor)
+            int32_t value = static_cast<int32_t>(scaled + 32768.5f) - 32768;
+            output[i + lane] = static_cast<int16_t>(std::min(32767, std::max(-32768, value)));
+        }
+    }
+
+    // Tail (odd sizes only; blocks are normally a multiple of LANES)
+    for (; i < count; ++i) {
+        int32_t value = static_cast<int32_t>(std::min(1.0f, std::max(-1.0f, input[i])) * SCALE + 32768.5f) - 32768;
+        output[i] = static_cast<int16_t>(std::min(32767, std::max(-32768, value)));
+    }
+
+    std::copy(state, state + LANES, rngState);
+}
+
+} // namespace DubSiren
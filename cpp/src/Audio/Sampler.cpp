@@ -0,0 +1,462 @@
+#include "Audio/Sampler.h"
+#include "Audio/SampleBank.h"
+#include "Audio/SampleConverter.h"
+#include "DSP/Resampler.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace DubSiren {
+
+namespace {
+
+// output += input * gain / 32768
+inline void mixS16(const int16_t* input, float gain, float* output, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t pcm = vld1q_s16(input + i);
+        float32x4_t lo = vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(pcm)), 15);
+        float32x4_t hi = vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(pcm)), 15);
+#if defined(__ARM_FEATURE_FMA)
+        vst1q_f32(output + i, vfmaq_n_f32(vld1q_f32(output + i), lo, gain));
+        vst1q_f32(output + i + 4, vfmaq_n_f32(vld1q_f32(output + i + 4), hi, gain));
+#else
+        vst1q_f32(output + i, vmlaq_n_f32(vld1q_f32(output + i), lo, gain));
+        vst1q_f32(output + i + 4, vmlaq_n_f32(vld1q_f32(output + i + 4), hi, gain));
+#endif
+    }
+#endif
+    // Remainder on NEON; the whole block elsewhere (auto-vectorized)
+    float scale = gain * (1.0f / 32768.0f);
+    for (; i < count; ++i) {
+        output[i] += static_cast<float>(input[i]) * scale;
+    }
+}
+
+constexpr int FRAC_BITS = 32;
+constexpr uint64_t FRAC_MASK = 0xFFFFFFFFull;
+constexpr float FIXED_ONE = 4294967296.0f;  // 1.0 in 32.32
+
+// One chunk of interpolator input: the four taps around each read
+// position, as planar arrays so the kernel runs across frames
+struct Taps {
+    alignas(16) float xm1[RAMP_CHUNK_SIZE];
+    alignas(16) float x0[RAMP_CHUNK_SIZE];
+    alignas(16) float x1[RAMP_CHUNK_SIZE];
+    alignas(16) float x2[RAMP_CHUNK_SIZE];
+    alignas(16) float frac[RAMP_CHUNK_SIZE];
+};
+
+inline void gather(const int16_t* data, uint64_t position, Taps& taps, int n) {
+    const int16_t* p = data + (position >> FRAC_BITS);
+    taps.xm1[n] = p[-1];
+    taps.x0[n] = p[0];
+    taps.x1[n] = p[1];
+    taps.x2[n] = p[2];
+    taps.frac[n] = static_cast<float>(position & FRAC_MASK) * (1.0f / FIXED_ONE);
+}
+
+// 4-point, 3rd-order Hermite (Catmull-Rom): output = value at frac
+inline void hermite(const Taps& taps, float* output, int count) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t m1 = vld1q_f32(taps.xm1 + i);
+        float32x4_t p0 = vld1q_f32(taps.x0 + i);
+        float32x4_t p1 = vld1q_f32(taps.x1 + i);
+        float32x4_t p2 = vld1q_f32(taps.x2 + i);
+        float32x4_t t = vld1q_f32(taps.frac + i);
+        float32x4_t c1 = vmulq_n_f32(vsubq_f32(p1, m1), 0.5f);
+        float32x4_t c2 = vsubq_f32(vaddq_f32(m1, vmulq_n_f32(p1, 2.0f)),
+                                   vaddq_f32(vmulq_n_f32(p0, 2.5f), vmulq_n_f32(p2, 0.5f)));
+        float32x4_t c3 = vaddq_f32(vmulq_n_f32(vsubq_f32(p2, m1), 0.5f),
+                                   vmulq_n_f32(vsubq_f32(p0, p1), 1.5f));
+        float32x4_t y = vmlaq_f32(c2, c3, t);
+        y = vmlaq_f32(c1, y, t);
+        vst1q_f32(output + i, vmlaq_f32(p0, y, t));
+    }
+#endif
+    for (; i < count; ++i) {
+        float m1 = taps.xm1[i], p0 = taps.x0[i], p1 = taps.x1[i], p2 = taps.x2[i];
+        float t = taps.frac[i];
+        float c1 = 0.5f * (p1 - m1);
+        float c2 = m1 - 2.5f * p0 + 2.0f * p1 - 0.5f * p2;
+        float c3 = 0.5f * (p2 - m1) + 1.5f * (p0 - p1);
+        output[i] = ((c3 * t + c2) * t + c1) * t + p0;
+    }
+}
+
+// A chunk of reads, one position per frame, through the octave levels
+struct Reads {
+    Taps taps;
+    Taps upper;                                 // The next level, when blending
+    alignas(16) float weight[RAMP_CHUNK_SIZE];  // Towards upper
+};
+
+// Frame n of a chunk: the level the rate is in and, when blending, the
+// next one down and how far towards it
+inline void gatherAt(const int16_t* const* data, uint64_t position, float rate, bool blend, Reads& reads, int n) {
+    if (blend) {
+        int level = rate > 2.0f ? 1 : 0;
+        reads.weight[n] = clamp(rate / static_cast<float>(1 << level) - 1.0f, 0.0f, 1.0f);
+        gather(data[level], position >> level, reads.taps, n);
+        gather(data[level + 1], position >> (level + 1), reads.upper, n);
+    } else {
+        gather(data[0], position, reads.taps, n);
+    }
+}
+
+inline void silenceAt(Reads& reads, int n) {
+    for (Taps* taps : {&reads.taps, &reads.upper}) {
+        taps->xm1[n] = taps->x0[n] = taps->x1[n] = taps->x2[n] = taps->frac[n] = 0.0f;
+    }
+    reads.weight[n] = 0.0f;
+}
+
+inline void interpolate(const Reads& reads, bool blend, float* output, float* scratch, int count) {
+    hermite(reads.taps, output, count);
+    if (blend) {
+        hermite(reads.upper, scratch, count);
+        for (int i = 0; i < count; ++i) {
+            output[i] += reads.weight[i] * (scratch[i] - output[i]);
+        }
+    }
+}
+
+// Sum of a[i] * b[i]
+inline float dot(const float* a, const float* b, int count) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    sum = vaddvq_f32(acc);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+#endif
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Frames [start, start + count) as float, zero outside the sample
+inline void loadFrames(const int16_t* data, long frames, long start, int count, float* output) {
+    for (int i = 0; i < count; ++i) {
+        long index = start + i;
+        output[i] = (index >= 0 && index < frames) ? static_cast<float>(data[index]) : 0.0f;
+    }
+}
+
+// Append one level with its guard frames; returns the first frame's offset
+size_t appendLevel(std::vector<int16_t>& pcm, const std::vector<float>& level, size_t guardBefore, size_t guardAfter) {
+    pcm.insert(pcm.end(), guardBefore, 0);
+    size_t offset = pcm.size();
+    pcm.resize(offset + level.size());
+    SampleConverter::roundToS16(level.data(), pcm.data() + offset, level.size());
+    pcm.insert(pcm.end(), guardAfter, 0);
+    return offset;
+}
+
+} // anonymous namespace
+
+Sampler::Sampler(int sampleRate)
+    : sampleRate(sampleRate)
+    , searchesLeft(0)
+{
+    // Raised-cosine crossfade: the two overlapping grains always sum to one
+    for (int i = 0; i < STRETCH_HOP; ++i) {
+        float s = std::sin(static_cast<float>(M_PI) * 0.5f * (static_cast<float>(i) + 0.5f) / STRETCH_HOP);
+        fadeIn[i] = s * s;
+    }
+}
+
+bool Sampler::loadBank(const std::string& path) {
+    SampleBank bank;
+    if (!bank.load(path)) {
+        return false;
+    }
+
+    pcm.clear();
+    samples.clear();
+    stopAll();
+
+    std::vector<float> stereo;
+    std::vector<float> mono;
+    for (int i = 0; i < bank.count(); ++i) {
+        const SampleBankEntry* entry = bank.entry(i);
+        size_t frames = static_cast<size_t>(entry->frames);
+
+        // Whole entry to float, then the channel average
+        stereo.resize(frames * SampleBank::CHANNELS);
+        if (bank.getFormat() == SampleBank::FORMAT_S16) {
+            SampleConverter::toFloat(static_cast<const int16_t*>(bank.data(*entry)), stereo.data(), stereo.size());
+        } else {
+            std::memcpy(stereo.data(), bank.data(*entry), stereo.size() * sizeof(float));
+        }
+        mono.resize(frames);
+        for (size_t f = 0; f < frames; ++f) {
+            mono[f] = 0.5f * (stereo[f * 2] + stereo[f * 2 + 1]);
+        }
+        if (sampleRate != SampleBank::SAMPLE_RATE) {
+            mono = PolyphaseResampler::convert(mono.data(), frames, 1, SampleBank::SAMPLE_RATE, sampleRate);
+        }
+
+        Sample sample;
+        sample.name.assign(entry->name, strnlen(entry->name, sizeof(entry->name)));
+        sample.frames = mono.size();
+        sample.offset[0] = appendLevel(pcm, mono, GUARD_BEFORE, GUARD_AFTER);
+
+        // Each level is the previous one decimated by two, time-aligned
+        for (int level = 1; level < LEVELS; ++level) {
+            mono = PolyphaseResampler::convert(mono.data(), mono.size(), 1, 2, 1);
+            sample.offset[level] = appendLevel(pcm, mono, GUARD_BEFORE, GUARD_AFTER);
+        }
+        samples.push_back(std::move(sample));
+    }
+
+    std::cout << "[Sampler] Loaded " << samples.size() << " sample(s) from " << path
+              << " (" << pcm.size() * sizeof(int16_t) / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+void Sampler::start(int sample, int offset, float gain, float stretch) {
+    if (sample < 0 || sample >= static_cast<int>(samples.size()) || samples[sample].frames == 0) {
+        return;
+    }
+
+    // A free voice, else the one that has played longest
+    Voice* voice = &voices[0];
+    for (Voice& v : voices) {
+        if (!v.data[0]) {
+            voice = &v;
+            break;
+        }
+        if (v.position > voice->position) {
+            voice = &v;
+        }
+    }
+
+    for (int level = 0; level < LEVELS; ++level) {
+        voice->data[level] = pcm.data() + samples[sample].offset[level];
+    }
+    voice->frames = samples[sample].frames;
+    voice->position = 0;
+    voice->delay = std::max(0, offset);
+    voice->gain = gain;
+
+    // Both grains start at the top, so the attack plays unfaded
+    voice->stretch = clamp(stretch, MIN_STRETCH, MAX_STRETCH);
+    voice->grain = {0, 0};
+    voice->hopPhase = 0;
+    voice->tail = false;
+}
+
+void Sampler::stopAll() {
+    for (Voice& voice : voices) {
+        voice.data[0] = nullptr;
+    }
+}
+
+void Sampler::mix(float* buffer, int numSamples, float busGain, const float* rate) {
+    searchesLeft = MAX_SEARCHES_PER_BLOCK;
+
+    // One scan of the rates for all voices: at original pitch the int16
+    // data is mixed directly, and only rates above 1x need the lower levels
+    bool unity = true;
+    float maxRate = 1.0f;
+    if (rate) {
+        for (int i = 0; i < numSamples; ++i) {
+            unity = unity && rate[i] == 1.0f;
+            maxRate = std::max(maxRate, rate[i]);
+        }
+    }
+
+    for (Voice& voice : voices) {
+        if (!voice.data[0]) {
+            continue;
+        }
+
+        // A voice started mid-block begins at its offset
+        int start = std::min(voice.delay, numSamples);
+        voice.delay -= start;
+        float gain = voice.gain * busGain;
+
+        if (voice.stretch != 1.0f) {
+            mixStretched(voice, buffer + start, rate ? rate + start : nullptr,
+                         numSamples - start, gain, maxRate > 1.0f);
+        } else if (unity && (voice.position & FRAC_MASK) == 0) {
+            size_t index = voice.position >> FRAC_BITS;
+            size_t count = std::min(static_cast<size_t>(numSamples - start), voice.frames - index);
+            mixS16(voice.data[0] + index, gain, buffer + start, count);
+            voice.position += static_cast<uint64_t>(count) << FRAC_BITS;
+            if (index + count == voice.frames) {
+                voice.data[0] = nullptr;
+            }
+        } else {
+            mixVarispeed(voice, buffer + start, rate ? rate + start : nullptr,
+                         numSamples - start, gain, maxRate > 1.0f);
+        }
+    }
+}
+
+void Sampler::mixVarispeed(Voice& voice, float* output, const float* rate, int count, float gain, bool blend) {
+    Reads reads;
+    alignas(16) float y[RAMP_CHUNK_SIZE];
+    alignas(16) float scratch[RAMP_CHUNK_SIZE];
+
+    const uint64_t end = static_cast<uint64_t>(voice.frames) << FRAC_BITS;
+    float scale = gain * (1.0f / 32768.0f);
+    int done = 0;
+    while (done < count && voice.position < end) {
+        int chunk = std::min(count - done, RAMP_CHUNK_SIZE);
+        int n = 0;
+        for (; n < chunk && voice.position < end; ++n) {
+            float r = rate ? clamp(rate[done + n], MIN_RATE, MAX_RATE) : 1.0f;
+            gatherAt(voice.data.data(), voice.position, r, blend, reads, n);
+            voice.position += static_cast<uint64_t>(r * FIXED_ONE);
+        }
+
+        interpolate(reads, blend, y, scratch, n);
+        float* out = output + done;
+        for (int i = 0; i < n; ++i) {
+            out[i] += y[i] * scale;
+        }
+        done += n;
+    }
+
+    if (voice.position >= end) {
+        voice.data[0] = nullptr;
+    }
+}
+
+void Sampler::mixStretched(Voice& voice, float* output, const float* rate, int count, float gain, bool blend) {
+    Reads fading;   // grain[0]
+    Reads rising;   // grain[1]
+    alignas(16) float fadingGain[RAMP_CHUNK_SIZE];
+    alignas(16) float risingGain[RAMP_CHUNK_SIZE];
+    alignas(16) float y[RAMP_CHUNK_SIZE];
+    alignas(16) float yRising[RAMP_CHUNK_SIZE];
+    alignas(16) float scratch[RAMP_CHUNK_SIZE];
+
+    const uint64_t end = static_cast<uint64_t>(voice.frames) << FRAC_BITS;
+    float scale = gain * (1.0f / 32768.0f);
+    float inverseStretch = 1.0f / voice.stretch;
+    int done = 0;
+    while (done < count && voice.data[0]) {
+        int chunk = std::min(count - done, RAMP_CHUNK_SIZE);
+        int n = 0;
+        for (; n < chunk; ++n) {
+            if (voice.hopPhase == STRETCH_HOP) {
+                if (voice.tail) {
+                    voice.data[0] = nullptr;
+                    break;
+                }
+                nextGrain(voice);
+            }
+
+            // Both grains play at the varispeed rate; the analysis position
+            // moves at rate / stretch
+            float r = rate ? clamp(rate[done + n], MIN_RATE, MAX_RATE) : 1.0f;
+            for (int g = 0; g < 2; ++g) {
+                Reads& reads = g == 0 ? fading : rising;
+                if (voice.grain[g] < end) {
+                    gatherAt(voice.data.data(), voice.grain[g], r, blend, reads, n);
+                } else {
+                    silenceAt(reads, n);
+                }
+            }
+            risingGain[n] = voice.tail ? 0.0f : fadeIn[voice.hopPhase];
+            fadingGain[n] = 1.0f - fadeIn[voice.hopPhase];
+
+            uint64_t step = static_cast<uint64_t>(r * FIXED_ONE);
+            voice.grain[0] += step;
+            voice.grain[1] += step;
+            voice.position += static_cast<uint64_t>(r * inverseStretch * FIXED_ONE);
+            ++voice.hopPhase;
+        }
+
+        interpolate(fading, blend, y, scratch, n);
+        interpolate(rising, blend, yRising, scratch, n);
+        float* out = output + done;
+        for (int i = 0; i < n; ++i) {
+            out[i] += (fadingGain[i] * y[i] + risingGain[i] * yRising[i]) * scale;
+        }
+        done += n;
+    }
+}
+
+void Sampler::nextGrain(Voice& voice) {
+    // The grain that was fading in fades out over the next hop
+    voice.grain[0] = voice.grain[1];
+    voice.hopPhase = 0;
+    if (voice.position >= static_cast<uint64_t>(voice.frames) << FRAC_BITS) {
+        voice.tail = true;
+        return;
+    }
+    voice.grain[1] = findGrain(voice, voice.grain[0], voice.position);
+}
+
+uint64_t Sampler::findGrain(const Voice& voice, uint64_t continuation, uint64_t nominal) {
+    // Out of search budget this block: cut at the nominal position
+    if (searchesLeft == 0) {
+        return nominal;
+    }
+    --searchesLeft;
+
+    const int16_t* data = voice.data[0];
+    long frames = static_cast<long>(voice.frames);
+    long centre = static_cast<long>(nominal >> FRAC_BITS);
+    long first = std::max(0L, centre - STRETCH_SEARCH);
+    int lags = static_cast<int>(centre + STRETCH_SEARCH - first) + 1;
+
+    // What the fading grain plays next, and every candidate window
+    loadFrames(data, frames, static_cast<long>(continuation >> FRAC_BITS), STRETCH_WINDOW, searchTarget.data());
+    loadFrames(data, frames, first, lags - 1 + STRETCH_WINDOW, searchSpan.data());
+    searchEnergy[0] = 0.0f;
+    for (int i = 0; i < lags - 1 + STRETCH_WINDOW; ++i) {
+        searchEnergy[i + 1] = searchEnergy[i] + searchSpan[i] * searchSpan[i];
+    }
+
+    // Normalized cross-correlation, every 4th lag and then around the best
+    auto score = [&](int lag) {
+        float energy = searchEnergy[lag + STRETCH_WINDOW] - searchEnergy[lag];
+        return dot(searchTarget.data(), searchSpan.data() + lag, STRETCH_WINDOW) / std::sqrt(energy + 1.0f);
+    };
+    int best = std::min(lags - 1, static_cast<int>(centre - first));
+    float bestScore = score(best);
+    for (int lag = 0; lag < lags; lag += 4) {
+        float value = score(lag);
+        if (value > bestScore) {
+            bestScore = value;
+            best = lag;
+        }
+    }
+    int coarse = best;
+    for (int lag = std::max(0, coarse - 3); lag <= std::min(lags - 1, coarse + 3); ++lag) {
+        float value = score(lag);
+        if (value > bestScore) {
+            bestScore = value;
+            best = lag;
+        }
+    }
+
+    int64_t shift = static_cast<int64_t>(first + best - centre);
+    return static_cast<uint64_t>(static_cast<int64_t>(nominal) + shift * (int64_t(1) << FRAC_BITS));
+}
+
+} // namespace DubSiren
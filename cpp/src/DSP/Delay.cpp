@@ -1,57 +1,78 @@
 #include "DSP/Delay.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 namespace DubSiren {
 
-DelayEffect::DelayEffect(int sampleRate, float maxDelay)
+DelayEffect::DelayEffect(int sampleRate, float maxDelay, LineStorage storage)
     : sampleRate(sampleRate)
     , maxDelaySamples(static_cast<int>(maxDelay * sampleRate))
-    , buffer(maxDelaySamples, 0.0f)
     , writePos(0)
-    , delayTime(0.3f)
-    , feedback(0.3f)
-    , dryWet(0.0f)
     , currentDelaySamples(0.3f * sampleRate)
-    , repitchRate(0.5f)
     , filterHpFreq(80.0f)
     , filterLpFreq(5000.0f)
     , hpState(0.0f)
     , lpState(0.0f)
-    , modDepth(0.003f)
-    , modRate(0.5f)
     , modPhase(0.0f)
     , flutterDepth(0.001f)
     , flutterRate(3.5f)
     , flutterPhase(0.0f)
-    , tapeSaturation(0.3f)
 {
-    slewRate = calculateSlewRate();
+    float smoothCoeff = SmoothedValue::coefficientFor(0.005f, sampleRate);  // ~5ms glide
+    dryWetSmooth = SmoothedValue(params.dryWet, smoothCoeff);
+    feedbackSmooth = SmoothedValue(params.feedback, smoothCoeff);
+    prepareParameters(params);
+    buffer.allocate(maxDelaySamples, storage);
 }
 
-float DelayEffect::calculateSlewRate() const {
-    if (repitchRate <= 0.0f) {
-        return std::numeric_limits<float>::infinity();
+void DelayEffect::setLineStorage(LineStorage storage) {
+    buffer.allocate(maxDelaySamples, storage);
+    writePos = 0;
+}
+
+void DelayEffect::setParameters(const Parameters& p) {
+    params = p;
+    dryWetSmooth.setTarget(p.dryWet);
+    feedbackSmooth.setTarget(p.feedback);
+}
+
+void DelayEffect::prepareParameters(Parameters& p) const {
+    p.delayTime = std::clamp(p.delayTime, 0.001f, 2.0f);
+    p.feedback = std::clamp(p.feedback, 0.0f, 0.95f);
+    p.dryWet = std::clamp(p.dryWet, 0.0f, 1.0f);
+    p.repitchRate = std::clamp(p.repitchRate, 0.0f, 1.0f);
+    p.modDepth = std::clamp(p.modDepth, 0.0f, 0.01f);
+    p.modRate = std::clamp(p.modRate, 0.1f, 5.0f);
+    p.tapeSaturation = std::clamp(p.tapeSaturation, 0.0f, 1.0f);
+
+    p.targetDelaySamples = p.delayTime * static_cast<float>(sampleRate);
+
+    // Analog repitch: slew across the whole line in 2 * repitchRate seconds
+    if (p.repitchRate <= 0.0f) {
+        p.slewRate = std::numeric_limits<float>::infinity();
+    } else {
+        float maxSlewTime = 2.0f * p.repitchRate;
+        p.slewRate = static_cast<float>(maxDelaySamples) / (maxSlewTime * static_cast<float>(sampleRate));
     }
-    float maxSlewTime = 2.0f * repitchRate;
-    return static_cast<float>(maxDelaySamples) / (maxSlewTime * static_cast<float>(sampleRate));
+
+    // Feedback filter coefficients (one-pole, matched-z)
+    p.hpCoeff = 1.0f - std::exp(-TWO_PI * filterHpFreq / static_cast<float>(sampleRate));
+    p.lpCoeff = 1.0f - std::exp(-TWO_PI * filterLpFreq / static_cast<float>(sampleRate));
 }
 
 float DelayEffect::processFeedbackFilters(float sample) {
     // High-pass filter (removes mud/low-end buildup)
-    float hpCutoffNorm = filterHpFreq / static_cast<float>(sampleRate);
-    float hpCoeff = 1.0f - std::exp(-TWO_PI * hpCutoffNorm);
-    hpState = clampSample(hpState + hpCoeff * (sample - hpState));
+    hpState = clampSample(hpState + params.hpCoeff * (sample - hpState));
     float filtered = sample - hpState;
     
     // Low-pass filter (tape-like high-frequency loss)
-    float lpCutoffNorm = filterLpFreq / static_cast<float>(sampleRate);
-    float lpCoeff = 1.0f - std::exp(-TWO_PI * lpCutoffNorm);
-    lpState = clampSample(lpState + lpCoeff * (filtered - lpState));
+    lpState = clampSample(lpState + params.lpCoeff * (filtered - lpState));
     
     // Tape-style saturation (gentle warmth)
-    float saturated = fastTanh(lpState * (1.0f + tapeSaturation * 2.0f));
-    float result = lpState * (1.0f - tapeSaturation) + saturated * tapeSaturation;
+    float saturation = params.tapeSaturation;
+    float saturated = fastTanh(lpState * (1.0f + saturation * 2.0f));
+    float result = lpState * (1.0f - saturation) + saturated * saturation;
     
     return result;
 }
@@ -72,13 +93,29 @@ float DelayEffect::lerpRead(float delaySamples) const {
     int idx1 = (readPosInt + 1) % maxDelaySamples;
     
     // Linear interpolation between samples
-    return buffer[idx0] * (1.0f - frac) + buffer[idx1] * frac;
+    return buffer.read(idx0) * (1.0f - frac) + buffer.read(idx1) * frac;
 }
 
 void DelayEffect::process(const float* input, float* output, int numSamples) {
-    float targetDelaySamples = delayTime * static_cast<float>(sampleRate);
+    const float targetDelaySamples = params.targetDelaySamples;
+    const float slewRate = params.slewRate;
+    const float modRate = params.modRate;
+    const float modDepth = params.modDepth;
+
+    float dryWetRamp[RAMP_CHUNK_SIZE];
+    float feedbackRamp[RAMP_CHUNK_SIZE];
     
     for (int i = 0; i < numSamples; ++i) {
+        // Refill parameter ramps every chunk
+        int rampIndex = i % RAMP_CHUNK_SIZE;
+        if (rampIndex == 0) {
+            int chunk = std::min(RAMP_CHUNK_SIZE, numSamples - i);
+            dryWetSmooth.process(dryWetRamp, chunk);
+            feedbackSmooth.process(feedbackRamp, chunk);
+        }
+        const float dryWet = dryWetRamp[rampIndex];
+        const float feedback = feedbackRamp[rampIndex];
+
         // Analog behavior: smoothly slew toward target delay time
         if (std::isinf(slewRate)) {
             currentDelaySamples = targetDelaySamples;
@@ -119,7 +156,7 @@ void DelayEffect::process(const float* input, float* output, int numSamples) {
         float feedbackSignal = processFeedbackFilters(delayed);
         
         // Write to buffer
-        buffer[writePos] = clampSample(input[i] + feedbackSignal * feedback);
+        buffer.write(writePos, clampSample(input[i] + feedbackSignal * feedback));
         
         // Advance write position
         writePos = (writePos + 1) % maxDelaySamples;
@@ -130,32 +167,52 @@ void DelayEffect::process(const float* input, float* output, int numSamples) {
 }
 
 void DelayEffect::setDelayTime(float timeSeconds) {
-    delayTime = std::clamp(timeSeconds, 0.001f, 2.0f);
+    Parameters p = params;
+    p.delayTime = timeSeconds;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setFeedback(float fb) {
-    feedback = std::clamp(fb, 0.0f, 0.95f);
+    Parameters p = params;
+    p.feedback = fb;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setDryWet(float mix) {
-    dryWet = std::clamp(mix, 0.0f, 1.0f);
+    Parameters p = params;
+    p.dryWet = mix;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setRepitchRate(float rate) {
-    repitchRate = std::clamp(rate, 0.0f, 1.0f);
-    slewRate = calculateSlewRate();
+    Parameters p = params;
+    p.repitchRate = rate;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setModDepth(float depth) {
-    modDepth = std::clamp(depth, 0.0f, 0.01f);
+    Parameters p = params;
+    p.modDepth = depth;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setModRate(float rate) {
-    modRate = std::clamp(rate, 0.1f, 5.0f);
+    Parameters p = params;
+    p.modRate = rate;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void DelayEffect::setTapeSaturation(float amount) {
-    tapeSaturation = std::clamp(amount, 0.0f, 1.0f);
+    Parameters p = params;
+    p.tapeSaturation = amount;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 } // namespace DubSiren
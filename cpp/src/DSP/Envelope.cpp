@@ -9,22 +9,22 @@ constexpr float DECAY_SCALE = 4.605f;
 
 Envelope::Envelope(int sampleRate)
     : sampleRate(sampleRate)
-    , attackTime(0.01f)    // 10ms default attack
-    , releaseTime(0.05f)   // 50ms default release
-    , attackCoeff(0.0f)
-    , releaseCoeff(0.0f)
     , currentValue(0.0f)
     , active(false)
 {
-    updateCoefficients();
+    // Defaults: 10ms attack, 50ms release
+    prepareParameters(params);
 }
 
-void Envelope::updateCoefficients() {
+void Envelope::prepareParameters(Parameters& p) const {
+    p.attackTime = std::clamp(p.attackTime, 0.001f, 2.0f);
+    p.releaseTime = std::clamp(p.releaseTime, 0.01f, 5.0f);
+
     // Attack coefficient: time to reach 99% of target
-    attackCoeff = DECAY_SCALE / (attackTime * static_cast<float>(sampleRate));
+    p.attackCoeff = DECAY_SCALE / (p.attackTime * static_cast<float>(sampleRate));
     
     // Release coefficient: time to decay to 1% of peak
-    releaseCoeff = DECAY_SCALE / (releaseTime * static_cast<float>(sampleRate));
+    p.releaseCoeff = DECAY_SCALE / (p.releaseTime * static_cast<float>(sampleRate));
 }
 
 void Envelope::generate(float* output, int numSamples) {
@@ -40,11 +40,11 @@ float Envelope::generateSample() {
     if (active.load(std::memory_order_acquire)) {
         // Attack: approach 1.0
         target = 1.0f;
-        coeff = attackCoeff;
+        coeff = params.attackCoeff;
     } else {
         // Release: approach 0.0
         target = 0.0f;
-        coeff = releaseCoeff;
+        coeff = params.releaseCoeff;
     }
     
     // Exponential approach to target (first-order filter)
@@ -62,13 +62,17 @@ void Envelope::release() {
 }
 
 void Envelope::setAttack(float timeSeconds) {
-    attackTime = std::clamp(timeSeconds, 0.001f, 2.0f);
-    updateCoefficients();
+    Parameters p = params;
+    p.attackTime = timeSeconds;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void Envelope::setRelease(float timeSeconds) {
-    releaseTime = std::clamp(timeSeconds, 0.01f, 5.0f);
-    updateCoefficients();
+    Parameters p = params;
+    p.releaseTime = timeSeconds;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 } // namespace DubSiren
@@ -22,31 +22,53 @@ static inline float tanhSat(float x) {
 
 LowPassFilter::LowPassFilter(int sampleRate)
     : sampleRate(std::max(1, sampleRate))
-    , cutoff(3000.0f)
-    , cutoffCurrent(3000.0f)
-    , resonance(1.0f)
-    , resonanceCurrent(1.0f)
+    , cutoffSmooth(3000.0f, 0.05f)
+    , resonanceSmooth(1.0f, 0.05f)
     , lpState(0.0f)
     , bpState(0.0f)
-    , smoothing(0.05f)
 {
 }
 
 void LowPassFilter::process(const float* input, float* output, int numSamples) {
-    for (int i = 0; i < numSamples; ++i) {
-        output[i] = processSample(input[i]);
+    float cutoffRamp[RAMP_CHUNK_SIZE];
+    float resonanceRamp[RAMP_CHUNK_SIZE];
+
+    for (int start = 0; start < numSamples; start += RAMP_CHUNK_SIZE) {
+        int count = std::min(RAMP_CHUNK_SIZE, numSamples - start);
+
+        if (!cutoffSmooth.isSmoothing() && !resonanceSmooth.isSmoothing()) {
+            // Settled: tune once for the whole chunk (no per-sample sin)
+            float f = tuningFor(cutoffSmooth.getTarget());
+            float qInv = 1.0f / resonanceSmooth.getTarget();
+            for (int i = start; i < start + count; ++i) {
+                output[i] = tick(input[i], f, qInv);
+            }
+            continue;
+        }
+
+        // Smooth parameter changes to prevent zipper noise
+        cutoffSmooth.process(cutoffRamp, count);
+        resonanceSmooth.process(resonanceRamp, count);
+        for (int i = 0; i < count; ++i) {
+            output[start + i] = tick(input[start + i], tuningFor(cutoffRamp[i]), 1.0f / resonanceRamp[i]);
+        }
     }
 }
 
 float LowPassFilter::processSample(float input) {
     // Smooth parameter changes to prevent zipper noise
-    cutoffCurrent += (cutoff - cutoffCurrent) * smoothing;
-    resonanceCurrent += (resonance - resonanceCurrent) * smoothing;
+    float fc = cutoffSmooth.getNext();
+    float res = resonanceSmooth.getNext();
+    return tick(input, tuningFor(fc), 1.0f / res);
+}
+
+float LowPassFilter::tuningFor(float cutoffHz) const {
+    float fc = std::min(cutoffHz, static_cast<float>(sampleRate) * 0.49f);
+    return 2.0f * std::sin(PI * fc / static_cast<float>(sampleRate));
+}
 
+float LowPassFilter::tick(float input, float f, float q_inv) {
     // Chamberlin State Variable Filter (2-pole, 12dB/oct).
-    float fc = std::min(cutoffCurrent, static_cast<float>(sampleRate) * 0.49f);
-    float f = 2.0f * std::sin(PI * fc / static_cast<float>(sampleRate));
-    float q_inv = 1.0f / resonanceCurrent;
 
     // SVF tick: lp → hp → bp (canonical Chamberlin order).
     // Computing lp first with the OLD bp state gives the classic delayed-
@@ -72,18 +94,18 @@ float LowPassFilter::processSample(float input) {
 }
 
 void LowPassFilter::setCutoff(float freq) {
-    cutoff = std::clamp(freq, 20.0f, 20000.0f);
+    cutoffSmooth.setTarget(std::clamp(freq, 20.0f, 20000.0f));
 }
 
 void LowPassFilter::setResonance(float res) {
-    resonance = std::clamp(res, 0.1f, 20.0f);
+    resonanceSmooth.setTarget(std::clamp(res, 0.1f, 20.0f));
 }
 
 void LowPassFilter::reset() {
     lpState = 0.0f;
     bpState = 0.0f;
-    cutoffCurrent = cutoff;
-    resonanceCurrent = resonance;
+    cutoffSmooth.setImmediate(cutoffSmooth.getTarget());
+    resonanceSmooth.setImmediate(resonanceSmooth.getTarget());
 }
 
 // ============================================================================
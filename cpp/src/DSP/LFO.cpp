@@ -5,24 +5,33 @@ namespace DubSiren {
 
 LFO::LFO(int sampleRate)
     : sampleRate(sampleRate)
-    , frequency(5.0f)    // 5 Hz default rate
     , phase(0.0f)
-    , waveform(Waveform::Sine)
-    , depth(0.0f)        // Disabled by default
 {
+    // Defaults: 5 Hz sine, depth 0 (disabled)
+    prepareParameters(params);
+    depthSmooth = SmoothedValue(params.depth, SmoothedValue::coefficientFor(0.005f, sampleRate));
 }
 
 void LFO::generate(float* output, int numSamples) {
-    for (int i = 0; i < numSamples; ++i) {
-        output[i] = generateSample();
+    float depthRamp[RAMP_CHUNK_SIZE];
+
+    for (int start = 0; start < numSamples; start += RAMP_CHUNK_SIZE) {
+        int count = std::min(RAMP_CHUNK_SIZE, numSamples - start);
+        depthSmooth.process(depthRamp, count);
+        for (int i = 0; i < count; ++i) {
+            output[start + i] = generateRaw() * depthRamp[i];
+        }
     }
 }
 
 float LFO::generateSample() {
+    return generateRaw() * depthSmooth.getNext();
+}
+
+float LFO::generateRaw() {
     float value = 0.0f;
-    float dt = frequency / static_cast<float>(sampleRate);
     
-    switch (waveform) {
+    switch (params.waveform) {
         case Waveform::Sine:
             value = std::sin(TWO_PI * phase);
             break;
@@ -45,24 +54,36 @@ float LFO::generateSample() {
     }
     
     // Advance phase
-    phase += dt;
+    phase += params.phaseIncrement;
     if (phase >= 1.0f) {
         phase -= 1.0f;
     }
     
-    return value * depth;
+    return value;
+}
+
+void LFO::prepareParameters(Parameters& p) const {
+    p.frequency = clamp(p.frequency, 0.1f, 20.0f);
+    p.depth = clamp(p.depth, 0.0f, 1.0f);
+    p.phaseIncrement = p.frequency / static_cast<float>(sampleRate);
 }
 
 void LFO::setFrequency(float freq) {
-    frequency = clamp(freq, 0.1f, 20.0f);
+    Parameters p = params;
+    p.frequency = freq;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void LFO::setWaveform(Waveform wf) {
-    waveform = wf;
+    params.waveform = wf;
 }
 
 void LFO::setDepth(float d) {
-    depth = clamp(d, 0.0f, 1.0f);
+    Parameters p = params;
+    p.depth = d;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 } // namespace DubSiren
@@ -0,0 +1,287 @@
+#include "DSP/Resampler.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace DubSiren {
+
+namespace {
+
+constexpr double KAISER_BETA = 7.0;  // ~70 dB stopband
+constexpr double ROLLOFF = 0.95;     // Cutoff as a fraction of the lower Nyquist
+
+static_assert(PolyphaseResampler::TAPS % 8 == 0, "dot() works in blocks of 8 taps");
+
+// Zeroth-order modified Bessel function (Kaiser window)
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// Multiply-accumulate four lanes
+#if defined(__ARM_NEON)
+inline float32x4_t mac(float32x4_t acc, float32x4_t x, float32x4_t h) {
+#if defined(__ARM_FEATURE_FMA)
+    return vfmaq_f32(acc, x, h);
+#else
+    return vmlaq_f32(acc, x, h);
+#endif
+}
+
+inline float horizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+#endif
+
+// One output sample: TAPS history samples against one phase of the bank
+inline float dot(const float* x, const float* h) {
+#if defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < PolyphaseResampler::TAPS; i += 8) {
+        acc0 = mac(acc0, vld1q_f32(x + i), vld1q_f32(h + i));
+        acc1 = mac(acc1, vld1q_f32(x + i + 4), vld1q_f32(h + i + 4));
+    }
+    return horizontalSum(vaddq_f32(acc0, acc1));
+#else
+    // Independent partial sums so the compiler can vectorize
+    float sum[8] = {};
+    for (int i = 0; i < PolyphaseResampler::TAPS; i += 8) {
+        for (int k = 0; k < 8; ++k) {
+            sum[k] += x[i + k] * h[i + k];
+        }
+    }
+    return ((sum[0] + sum[4]) + (sum[1] + sum[5])) + ((sum[2] + sum[6]) + (sum[3] + sum[7]));
+#endif
+}
+
+// Both channels of a stereo frame, loading each coefficient once
+inline void dotStereo(const float* left, const float* right, const float* h, float* out) {
+#if defined(__ARM_NEON)
+    float32x4_t accL0 = vdupq_n_f32(0.0f);
+    float32x4_t accL1 = vdupq_n_f32(0.0f);
+    float32x4_t accR0 = vdupq_n_f32(0.0f);
+    float32x4_t accR1 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < PolyphaseResampler::TAPS; i += 8) {
+        float32x4_t h0 = vld1q_f32(h + i);
+        float32x4_t h1 = vld1q_f32(h + i + 4);
+        accL0 = mac(accL0, vld1q_f32(left + i), h0);
+        accL1 = mac(accL1, vld1q_f32(left + i + 4), h1);
+        accR0 = mac(accR0, vld1q_f32(right + i), h0);
+        accR1 = mac(accR1, vld1q_f32(right + i + 4), h1);
+    }
+    out[0] = horizontalSum(vaddq_f32(accL0, accL1));
+    out[1] = horizontalSum(vaddq_f32(accR0, accR1));
+#else
+    out[0] = dot(left, h);
+    out[1] = dot(right, h);
+#endif
+}
+
+} // anonymous namespace
+
+PolyphaseResampler::PolyphaseResampler(int channels)
+    : channels(std::max(1, channels))
+    , up(1)
+    , down(1)
+    , phases(1)
+    , inputRate(0)
+    , outputRate(0)
+    , fill(0)
+    , pos(0)
+    , phase(0)
+    , inputTotal(0)
+    , outputTotal(0)
+{
+}
+
+void PolyphaseResampler::configure(int newInputRate, int newOutputRate) {
+    if (newInputRate != inputRate || newOutputRate != outputRate) {
+        inputRate = newInputRate;
+        outputRate = newOutputRate;
+
+        if (inputRate > 0 && outputRate > 0) {
+            int divisor = std::gcd(inputRate, outputRate);
+            up = outputRate / divisor;
+            down = inputRate / divisor;
+        } else {
+            up = down = 1;
+        }
+
+        // Rates outside the MP3 set may need more phases than are kept:
+        // the nearest one is used (at most 1/(2 * MAX_PHASES) sample off)
+        phases = std::min(up, MAX_PHASES);
+
+        if (!isPassthrough()) {
+            designBank();
+            history.assign(static_cast<size_t>(channels) * HISTORY_FRAMES, 0.0f);
+            zeros.assign(static_cast<size_t>(channels) * (TAPS / 2 + 1), 0.0f);
+        }
+    }
+
+    reset();
+}
+
+void PolyphaseResampler::designBank() {
+    // Cutoff in input-sample units: input Nyquist when upsampling, output
+    // Nyquist when downsampling
+    double cutoff = 0.5 * std::min(1.0, static_cast<double>(up) / down) * ROLLOFF;
+    double halfLength = TAPS / 2;
+    double windowNorm = besselI0(KAISER_BETA);
+
+    bank.assign(static_cast<size_t>(phases) * TAPS, 0.0f);
+    for (int p = 0; p < phases; ++p) {
+        float* taps = &bank[static_cast<size_t>(p) * TAPS];
+        double frac = static_cast<double>(p) / phases;
+        double sum = 0.0;
+
+        for (int j = 0; j < TAPS; ++j) {
+            // Distance from tap j to the output instant
+            double t = (halfLength - 1 - j) + frac;
+            double x = 2.0 * cutoff * t;
+            double sinc = (x == 0.0) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            double w = t / halfLength;
+            double window = (w * w < 1.0) ? besselI0(KAISER_BETA * std::sqrt(1.0 - w * w)) / windowNorm : 0.0;
+            double value = 2.0 * cutoff * sinc * window;
+            taps[j] = static_cast<float>(value);
+            sum += value;
+        }
+
+        // Unity DC gain on every phase (no ripple at the phase rate)
+        for (int j = 0; j < TAPS; ++j) {
+            taps[j] = static_cast<float>(taps[j] / sum);
+        }
+    }
+}
+
+void PolyphaseResampler::reset() {
+    std::fill(history.begin(), history.end(), 0.0f);
+
+    // Half a filter of silence ahead of the first input centres output 0 on it
+    fill = TAPS / 2 - 1;
+    pos = 0;
+    phase = 0;
+    inputTotal = 0;
+    outputTotal = 0;
+}
+
+size_t PolyphaseResampler::maxOutputFrames(size_t inputFrames) const {
+    if (isPassthrough()) {
+        return inputFrames;
+    }
+    return (inputFrames + TAPS) * up / down + 1;
+}
+
+size_t PolyphaseResampler::process(const float* input, size_t inputFrames, float* output) {
+    size_t written;
+    if (isPassthrough()) {
+        std::memcpy(output, input, inputFrames * channels * sizeof(float));
+        written = inputFrames;
+    } else {
+        written = run(input, inputFrames, output, static_cast<size_t>(-1));
+    }
+
+    inputTotal += inputFrames;
+    outputTotal += written;
+    return written;
+}
+
+size_t PolyphaseResampler::flush(float* output) {
+    if (isPassthrough()) {
+        return 0;
+    }
+
+    // Run half a filter of silence through, keeping only the frames the
+    // input length accounts for
+    uint64_t target = (inputTotal * up + down - 1) / down;
+    if (outputTotal >= target) {
+        return 0;
+    }
+
+    size_t written = run(zeros.data(), TAPS / 2 + 1, output, static_cast<size_t>(target - outputTotal));
+    outputTotal += written;
+    return written;
+}
+
+size_t PolyphaseResampler::run(const float* input, size_t inputFrames, float* output, size_t maxOutput) {
+    size_t written = 0;
+
+    while (true) {
+        while (pos + TAPS <= fill && written < maxOutput) {
+            int index = (phases == up) ? phase
+                                       : static_cast<int>(static_cast<int64_t>(phase) * phases / up);
+            const float* taps = &bank[static_cast<size_t>(index) * TAPS];
+            if (channels == 2) {
+                dotStereo(&history[pos], &history[HISTORY_FRAMES + pos], taps, &output[written * 2]);
+            } else {
+                for (int c = 0; c < channels; ++c) {
+                    output[written * channels + c] = dot(&history[c * HISTORY_FRAMES + pos], taps);
+                }
+            }
+            ++written;
+
+            phase += down;
+            pos += static_cast<size_t>(phase / up);
+            phase %= up;
+        }
+
+        if (inputFrames == 0 || written >= maxOutput) {
+            break;
+        }
+
+        // Slide the unread history down, then append as much input as fits
+        size_t shift = std::min(pos, fill);
+        if (shift > 0) {
+            for (int c = 0; c < channels; ++c) {
+                float* h = &history[c * HISTORY_FRAMES];
+                std::memmove(h, h + shift, (fill - shift) * sizeof(float));
+            }
+            fill -= shift;
+            pos -= shift;
+        }
+
+        size_t frames = std::min(inputFrames, HISTORY_FRAMES - fill);
+        for (int c = 0; c < channels; ++c) {
+            float* h = &history[c * HISTORY_FRAMES + fill];
+            for (size_t i = 0; i < frames; ++i) {
+                h[i] = input[i * channels + c];
+            }
+        }
+        fill += frames;
+        input += frames * channels;
+        inputFrames -= frames;
+    }
+
+    return written;
+}
+
+std::vector<float> PolyphaseResampler::convert(const float* input, size_t frames, int channels,
+                                               int inputRate, int outputRate) {
+    PolyphaseResampler resampler(channels);
+    resampler.configure(inputRate, outputRate);
+
+    std::vector<float> output((resampler.maxOutputFrames(frames) + resampler.maxOutputFrames(TAPS)) * channels);
+    size_t written = resampler.process(input, frames, output.data());
+    written += resampler.flush(output.data() + written * channels);
+    output.resize(written * channels);
+    return output;
+}
+
+} // namespace DubSiren
@@ -8,50 +8,56 @@ namespace DubSiren {
 // Biquad Filter Implementation
 // ============================================================================
 
-void ReverbEffect::Biquad::setLowpass(float freq, float q, float sampleRate) {
+ReverbEffect::BiquadCoeffs ReverbEffect::BiquadCoeffs::lowpass(float freq, float q, float sampleRate) {
+    BiquadCoeffs c;
     float omega = 2.0f * M_PI * freq / sampleRate;
     float cosOmega = std::cos(omega);
     float sinOmega = std::sin(omega);
     float alpha = sinOmega / (2.0f * q);
 
     float a0 = 1.0f + alpha;
-    b0 = ((1.0f - cosOmega) / 2.0f) / a0;
-    b1 = (1.0f - cosOmega) / a0;
-    b2 = b0;
-    a1 = (-2.0f * cosOmega) / a0;
-    a2 = (1.0f - alpha) / a0;
+    c.b0 = ((1.0f - cosOmega) / 2.0f) / a0;
+    c.b1 = (1.0f - cosOmega) / a0;
+    c.b2 = c.b0;
+    c.a1 = (-2.0f * cosOmega) / a0;
+    c.a2 = (1.0f - alpha) / a0;
+    return c;
 }
 
-void ReverbEffect::Biquad::setBandpass(float freq, float q, float sampleRate) {
+ReverbEffect::BiquadCoeffs ReverbEffect::BiquadCoeffs::bandpass(float freq, float q, float sampleRate) {
+    BiquadCoeffs c;
     float omega = 2.0f * M_PI * freq / sampleRate;
     float cosOmega = std::cos(omega);
     float sinOmega = std::sin(omega);
     float alpha = sinOmega / (2.0f * q);
 
     float a0 = 1.0f + alpha;
-    b0 = alpha / a0;
-    b1 = 0.0f;
-    b2 = -alpha / a0;
-    a1 = (-2.0f * cosOmega) / a0;
-    a2 = (1.0f - alpha) / a0;
+    c.b0 = alpha / a0;
+    c.b1 = 0.0f;
+    c.b2 = -alpha / a0;
+    c.a1 = (-2.0f * cosOmega) / a0;
+    c.a2 = (1.0f - alpha) / a0;
+    return c;
 }
 
-void ReverbEffect::Biquad::setHighpass(float freq, float q, float sampleRate) {
+ReverbEffect::BiquadCoeffs ReverbEffect::BiquadCoeffs::highpass(float freq, float q, float sampleRate) {
+    BiquadCoeffs c;
     float omega = 2.0f * M_PI * freq / sampleRate;
     float cosOmega = std::cos(omega);
     float sinOmega = std::sin(omega);
     float alpha = sinOmega / (2.0f * q);
 
     float a0 = 1.0f + alpha;
-    b0 = ((1.0f + cosOmega) / 2.0f) / a0;
-    b1 = -(1.0f + cosOmega) / a0;
-    b2 = b0;
-    a1 = (-2.0f * cosOmega) / a0;
-    a2 = (1.0f - alpha) / a0;
+    c.b0 = ((1.0f + cosOmega) / 2.0f) / a0;
+    c.b1 = -(1.0f + cosOmega) / a0;
+    c.b2 = c.b0;
+    c.a1 = (-2.0f * cosOmega) / a0;
+    c.a2 = (1.0f - alpha) / a0;
+    return c;
 }
 
 float ReverbEffect::Biquad::process(float input) {
-    float output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    float output = c.b0 * input + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
 
     // Prevent denormals
     if (std::abs(output) < 1e-10f) {
@@ -74,9 +80,9 @@ void ReverbEffect::Biquad::reset() {
 // Spring Line Implementation
 // ============================================================================
 
-void ReverbEffect::SpringLine::init(int length, float sampleRate, int springIndex) {
+void ReverbEffect::SpringLine::init(int length, float sampleRate, int springIndex, LineStorage storage) {
     delayLength = length;
-    delayBuffer.resize(length, 0.0f);
+    delayBuffer.allocate(length, storage);
     writeIndex = 0;
     feedback = 0.85f;  // Default, will be updated
 
@@ -109,7 +115,7 @@ void ReverbEffect::SpringLine::init(int length, float sampleRate, int springInde
 
 float ReverbEffect::SpringLine::process(float input) {
     // Read from delay line
-    float delayed = delayBuffer[writeIndex];
+    float delayed = delayBuffer.read(writeIndex);
 
     // Apply modal resonances to create spring character
     float modal = delayed;
@@ -135,13 +141,13 @@ float ReverbEffect::SpringLine::process(float input) {
     if (feedbackSig > 2.0f) feedbackSig = 2.0f;
     if (feedbackSig < -2.0f) feedbackSig = -2.0f;
 
-    delayBuffer[writeIndex] = feedbackSig;
-
     // Prevent denormals
-    if (std::abs(delayBuffer[writeIndex]) < 1e-10f) {
-        delayBuffer[writeIndex] = 0.0f;
+    if (std::abs(feedbackSig) < 1e-10f) {
+        feedbackSig = 0.0f;
     }
 
+    delayBuffer.write(writeIndex, feedbackSig);
+
     // Advance write position
     writeIndex = (writeIndex + 1) % delayLength;
 
@@ -152,24 +158,26 @@ float ReverbEffect::SpringLine::process(float input) {
 // Allpass Filter Implementation
 // ============================================================================
 
-void ReverbEffect::AllpassFilter::init(int size) {
+void ReverbEffect::AllpassFilter::init(int size, LineStorage storage) {
     bufferSize = size;
-    buffer.resize(size, 0.0f);
+    buffer.allocate(size, storage);
     index = 0;
 }
 
 float ReverbEffect::AllpassFilter::process(float input) {
-    float bufOut = buffer[index];
+    float bufOut = buffer.read(index);
 
     // Standard allpass with feedback coefficient of 0.5
     float output = -input + bufOut;
-    buffer[index] = input + (bufOut * 0.5f);
+    float stored = input + (bufOut * 0.5f);
 
     // Prevent denormals
-    if (std::abs(buffer[index]) < 1e-10f) {
-        buffer[index] = 0.0f;
+    if (std::abs(stored) < 1e-10f) {
+        stored = 0.0f;
     }
 
+    buffer.write(index, stored);
+
     index = (index + 1) % bufferSize;
 
     return output;
@@ -179,63 +187,93 @@ float ReverbEffect::AllpassFilter::process(float input) {
 // ReverbEffect Implementation
 // ============================================================================
 
-ReverbEffect::ReverbEffect(int sampleRate)
+ReverbEffect::ReverbEffect(int sampleRate, LineStorage storage)
     : sampleRate(sampleRate)
     , sampleRateInv(1.0f / sampleRate)
-    , springDecay(0.65f)      // Default: moderate-long decay (safer)
-    , damping(0.65f)          // Default: dark character
-    , wet(0.35f)              // Default: 35% wet
-    , dry(0.65f)
-    , width(1.0f)             // Default: full stereo width
 {
+    // Defaults: moderate-long decay (safer), dark character, 35% wet, full width
+    setLineStorage(storage);
+
+    // Initialize input transducer (lowpass ~4kHz, models mechanical bandwidth)
+    inputTransducer.setLowpass(4000.0f, 0.7f, sampleRate);
+
+    // Initialize output transducers (bandpass ~80Hz - 6kHz, models pickup coil)
+    outputLowcut.setHighpass(80.0f, 0.7f, sampleRate);
+    outputHighcut.setLowpass(6000.0f, 0.7f, sampleRate);
+
+    Parameters p;
+    prepareParameters(p);
+    wetSmooth = SmoothedValue(p.wet, SmoothedValue::coefficientFor(0.005f, sampleRate));  // ~5ms glide
+    setParameters(p);
+}
+
+void ReverbEffect::setLineStorage(LineStorage storage) {
     // Scale delay lengths for sample rate
     float scale = static_cast<float>(sampleRate) / 48000.0f;
 
     // Initialize spring lines (left channel)
     for (int i = 0; i < NUM_SPRINGS; ++i) {
         int len = static_cast<int>(SPRING_LENGTHS[i] * scale);
-        springsL[i].init(len, sampleRate, i);
-        springsR[i].init(len + STEREO_SPREAD, sampleRate, i);  // Offset for stereo
+        springsL[i].init(len, sampleRate, i, storage);
+        springsR[i].init(len + STEREO_SPREAD, sampleRate, i, storage);  // Offset for stereo
     }
 
     // Initialize allpass filters for diffusion
     for (int i = 0; i < NUM_ALLPASS; ++i) {
         int len = static_cast<int>(ALLPASS_LENGTHS[i] * scale);
-        allpassL[i].init(len);
-        allpassR[i].init(len + STEREO_SPREAD);
+        allpassL[i].init(len, storage);
+        allpassR[i].init(len + STEREO_SPREAD, storage);
     }
 
-    // Initialize input transducer (lowpass ~4kHz, models mechanical bandwidth)
-    inputTransducer.setLowpass(4000.0f, 0.7f, sampleRate);
-
-    // Initialize output transducers (bandpass ~80Hz - 6kHz, models pickup coil)
-    outputLowcut.setHighpass(80.0f, 0.7f, sampleRate);
-    outputHighcut.setLowpass(6000.0f, 0.7f, sampleRate);
-
-    updateCoefficients();
+    // init() put back the default spring feedback and damping
+    setParameters(params);
 }
 
-void ReverbEffect::updateCoefficients() {
+void ReverbEffect::prepareParameters(Parameters& p) const {
+    p.size = std::clamp(p.size, 0.0f, 1.0f);
+    p.damping = std::clamp(p.damping, 0.0f, 1.0f);
+    p.wet = std::clamp(p.wet, 0.0f, 1.0f);
+    p.width = std::clamp(p.width, 0.0f, 1.0f);
+
     // Update spring feedback based on decay parameter
     // Higher decay = longer reverb tail
     // Reduced range to prevent feedback loops when combined with delay
-    float feedbackAmount = 0.5f + (springDecay * 0.25f);  // Range: 0.5 - 0.75 (safer)
+    float feedbackAmount = 0.5f + (p.size * 0.25f);  // Range: 0.5 - 0.75 (safer)
     feedbackAmount = std::min(feedbackAmount, 0.75f);
 
     for (int i = 0; i < NUM_SPRINGS; ++i) {
         // Slightly different feedback for each spring to avoid buildup
-        springsL[i].feedback = feedbackAmount * (0.92f + i * 0.015f);
-        springsR[i].feedback = feedbackAmount * (0.92f + i * 0.015f);
+        p.springFeedback[i] = feedbackAmount * (0.92f + i * 0.015f);
+    }
 
-        // Update damping filter based on damping parameter
-        float dampFreq = 2000.0f + (1.0f - damping) * 4000.0f;  // 2kHz - 6kHz
-        springsL[i].dampingFilter.setLowpass(dampFreq, 0.7f, sampleRate);
-        springsR[i].dampingFilter.setLowpass(dampFreq, 0.7f, sampleRate);
+    // Damping filter cutoff based on damping parameter
+    float dampFreq = 2000.0f + (1.0f - p.damping) * 4000.0f;  // 2kHz - 6kHz
+    p.dampingCoeffs = BiquadCoeffs::lowpass(dampFreq, 0.7f, static_cast<float>(sampleRate));
+}
+
+void ReverbEffect::setParameters(const Parameters& p) {
+    params = p;
+    wetSmooth.setTarget(p.wet);
+
+    for (int i = 0; i < NUM_SPRINGS; ++i) {
+        springsL[i].feedback = p.springFeedback[i];
+        springsR[i].feedback = p.springFeedback[i];
+        springsL[i].dampingFilter.c = p.dampingCoeffs;
+        springsR[i].dampingFilter.c = p.dampingCoeffs;
     }
 }
 
 void ReverbEffect::process(const float* input, float* output, int numSamples) {
+    float wetRamp[RAMP_CHUNK_SIZE];
+
     for (int i = 0; i < numSamples; ++i) {
+        // Refill the mix ramp every chunk
+        int rampIndex = i % RAMP_CHUNK_SIZE;
+        if (rampIndex == 0) {
+            wetSmooth.process(wetRamp, std::min(RAMP_CHUNK_SIZE, numSamples - i));
+        }
+        const float wet = wetRamp[rampIndex];
+
         float inSample = input[i];
 
         // Input transducer: lowpass filter + soft saturation
@@ -269,13 +307,13 @@ void ReverbEffect::process(const float* input, float* output, int numSamples) {
 
         // Stereo width control
         float mid = (springOutL + springOutR) * 0.5f;
-        float side = (springOutL - springOutR) * 0.5f * width;
+        float side = (springOutL - springOutR) * 0.5f * params.width;
         springOutL = mid + side;
         springOutR = mid - side;
 
         // Mix wet/dry (output is mono, so average L+R)
         float wetMix = (springOutL + springOutR) * 0.5f * wet * OUTPUT_GAIN;
-        float dryMix = inSample * dry;
+        float dryMix = inSample * (1.0f - wet);
 
         float finalOut = wetMix + dryMix;
 
@@ -288,22 +326,31 @@ void ReverbEffect::process(const float* input, float* output, int numSamples) {
 }
 
 void ReverbEffect::setSize(float size) {
-    springDecay = std::clamp(size, 0.0f, 1.0f);
-    updateCoefficients();
+    Parameters p = params;
+    p.size = size;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void ReverbEffect::setDryWet(float mix) {
-    wet = std::clamp(mix, 0.0f, 1.0f);
-    dry = 1.0f - wet;
+    Parameters p = params;
+    p.wet = mix;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void ReverbEffect::setDamping(float damp) {
-    damping = std::clamp(damp, 0.0f, 1.0f);
-    updateCoefficients();
+    Parameters p = params;
+    p.damping = damp;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 void ReverbEffect::setWidth(float w) {
-    width = std::clamp(w, 0.0f, 1.0f);
+    Parameters p = params;
+    p.width = w;
+    prepareParameters(p);
+    setParameters(p);
 }
 
 } // namespace DubSiren
@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 #ifdef HAVE_GPIOD
 #include <gpiod.h>
@@ -42,7 +43,12 @@ const size_t NUM_PINS = sizeof(ALL_PINS) / sizeof(ALL_PINS[0]);
 // Max GPIO on Pi is 27, so array of 28 elements
 int gpioToLineIndex[28] = {-1};
 
-bool initPlatformGPIO() {
+// Pin with kernel edge detection (-1: none) and its event buffer
+int edgePin = -1;
+struct gpiod_edge_event_buffer* edgeBuffer = nullptr;
+constexpr size_t EDGE_BUFFER_SIZE = 16;
+
+bool initPlatformGPIO(int edgeDetectPin) {
     if (gpioInitialized) return true;
     
     // Initialize GPIO-to-line-index lookup table
@@ -64,6 +70,23 @@ bool initPlatformGPIO() {
     
     struct gpiod_line_config* config = gpiod_line_config_new();
     gpiod_line_config_add_line_settings(config, ALL_PINS, NUM_PINS, settings);
+
+    // Timestamped edge events (CLOCK_MONOTONIC, same as monotonicNanos())
+    // on the one pin that wants them; values can still be read as usual
+    edgePin = -1;
+    if (edgeDetectPin >= 0 && edgeDetectPin <= 27 && gpioToLineIndex[edgeDetectPin] >= 0) {
+        struct gpiod_line_settings* edgeSettings = gpiod_line_settings_copy(settings);
+        gpiod_line_settings_set_edge_detection(edgeSettings, GPIOD_LINE_EDGE_BOTH);
+        gpiod_line_settings_set_event_clock(edgeSettings, GPIOD_LINE_CLOCK_MONOTONIC);
+        unsigned int offset = static_cast<unsigned int>(edgeDetectPin);
+        gpiod_line_config_add_line_settings(config, &offset, 1, edgeSettings);
+        gpiod_line_settings_free(edgeSettings);
+
+        edgeBuffer = gpiod_edge_event_buffer_new(EDGE_BUFFER_SIZE);
+        if (edgeBuffer) {
+            edgePin = edgeDetectPin;
+        }
+    }
     
     struct gpiod_request_config* reqConfig = gpiod_request_config_new();
     gpiod_request_config_set_consumer(reqConfig, "dubsiren");
@@ -91,6 +114,11 @@ void cleanupPlatformGPIO() {
         gpiod_line_request_release(lineRequest);
         lineRequest = nullptr;
     }
+    if (edgeBuffer) {
+        gpiod_edge_event_buffer_free(edgeBuffer);
+        edgeBuffer = nullptr;
+    }
+    edgePin = -1;
     if (gpioChip) {
         gpiod_chip_close(gpioChip);
         gpioChip = nullptr;
@@ -114,9 +142,37 @@ int readPin(int pin) {
     return value == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
 }
 
+/**
+ * Sleep until an edge on pin or the timeout.
+ * Drains all queued events; returns the pin level after the first one
+ * (0 = falling, 1 = rising) and its timestamp, or -1 on timeout.
+ * Pins without edge detection sleep briefly and return -1 (caller polls).
+ */
+int waitForEdge(int pin, int timeoutMs, int64_t& timestampNs) {
+    if (pin != edgePin || !lineRequest) {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeoutMs * 1000, 250)));
+        return -1;
+    }
+
+    int ready = gpiod_line_request_wait_edge_events(lineRequest, static_cast<int64_t>(timeoutMs) * 1000000LL);
+    if (ready <= 0) {
+        return -1;
+    }
+
+    int numEvents = gpiod_line_request_read_edge_events(lineRequest, edgeBuffer, EDGE_BUFFER_SIZE);
+    if (numEvents <= 0) {
+        return -1;
+    }
+
+    struct gpiod_edge_event* event = gpiod_edge_event_buffer_get_event(edgeBuffer, 0);
+    timestampNs = static_cast<int64_t>(gpiod_edge_event_get_timestamp_ns(event));
+    return gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_FALLING_EDGE ? 0 : 1;
+}
+
 #elif defined(HAVE_PIGPIO)
 
-bool initPlatformGPIO() {
+bool initPlatformGPIO(int edgeDetectPin) {
+    (void)edgeDetectPin;
     if (!gpioInitialized) {
         if (gpioInitialise() < 0) {
             std::cerr << "Failed to initialize pigpio" << std::endl;
@@ -143,9 +199,17 @@ void setupInputPin(int pin) {
     gpioSetPullUpDown(pin, PI_PUD_UP);
 }
 
+int waitForEdge(int pin, int timeoutMs, int64_t& timestampNs) {
+    (void)pin;
+    (void)timestampNs;
+    std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeoutMs * 1000, 250)));
+    return -1;
+}
+
 #else
 
-bool initPlatformGPIO() {
+bool initPlatformGPIO(int edgeDetectPin) {
+    (void)edgeDetectPin;
     std::cout << "GPIO not available - running in simulation mode" << std::endl;
     return false;
 }
@@ -162,6 +226,13 @@ void setupInputPin(int pin) {
     (void)pin;
 }
 
+int waitForEdge(int pin, int timeoutMs, int64_t& timestampNs) {
+    (void)pin;
+    (void)timestampNs;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return -1;
+}
+
 #endif
 
 } // anonymous namespace
@@ -255,6 +326,8 @@ MomentarySwitch::MomentarySwitch(int pin, PressCallback onPress, ReleaseCallback
     , releaseCallback(std::move(onRelease))
     , pressed(false)
     , running(false)
+    , lastEdgeNs(0)
+    , leadingEdge(false)
     , lastState(1)
 {
     lastChange = std::chrono::steady_clock::now();
@@ -274,7 +347,9 @@ void MomentarySwitch::start() {
 #endif
     
     running.store(true);
-    pollThread = std::thread(&MomentarySwitch::pollLoop, this);
+    pollThread = leadingEdge
+        ? std::thread(&MomentarySwitch::edgeLoop, this)
+        : std::thread(&MomentarySwitch::pollLoop, this);
 }
 
 void MomentarySwitch::stop() {
@@ -307,7 +382,7 @@ void MomentarySwitch::pollLoop() {
         
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastChange).count();
         if (elapsed < DEBOUNCE_MS) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
             continue;
         }
         
@@ -315,6 +390,8 @@ void MomentarySwitch::pollLoop() {
         if (state == 0 && !pressed.load()) {
             pressed.store(true);
             lastPressTime = now;
+            lastEdgeNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                lastChange.time_since_epoch()).count());
             if (pressCallback) {
                 pressCallback();
             }
@@ -323,13 +400,72 @@ void MomentarySwitch::pollLoop() {
             auto pressDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastPressTime).count();
             if (pressDuration >= MIN_PRESS_MS) {
                 pressed.store(false);
+                lastEdgeNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    lastChange.time_since_epoch()).count());
                 if (releaseCallback) {
                     releaseCallback();
                 }
             }
         }
         
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+    }
+}
+
+float MomentarySwitch::detectLatencyMs(bool leadingEdge) {
+    // Leading edge: an edge event wakes the thread within scheduler latency,
+    // or the 250 us fallback poll sees it. Otherwise the contact is sampled
+    // every POLL_MS and must then be stable for DEBOUNCE_MS
+    return leadingEdge ? 0.25f : static_cast<float>(POLL_MS + DEBOUNCE_MS);
+}
+
+void MomentarySwitch::edgeLoop() {
+    // Leading-edge debounce: the first edge is the press (or release), the
+    // bounce that follows is ignored until lockoutUntilNs
+    int64_t lockoutUntilNs = 0;
+
+    while (running.load()) {
+        int64_t nowNs = monotonicNanos();
+        int timeoutMs = EDGE_IDLE_TIMEOUT_MS;
+        if (nowNs < lockoutUntilNs) {
+            timeoutMs = static_cast<int>((lockoutUntilNs - nowNs + 999999) / 1000000);
+        }
+
+        int64_t edgeNs = 0;
+        int state = waitForEdge(pin, timeoutMs, edgeNs);
+        nowNs = monotonicNanos();
+
+        if (nowNs < lockoutUntilNs) {
+            continue;  // Still bouncing
+        }
+
+        // No edge (timeout, or polling platform): the level catches changes
+        // that completed during the lockout
+        if (state < 0) {
+            state = readPin(pin);
+            edgeNs = nowNs;
+        }
+
+        bool isDown = (state == 0);
+        if (isDown == pressed.load()) {
+            continue;
+        }
+
+        pressed.store(isDown);
+        lastEdgeNs.store(edgeNs);
+        lockoutUntilNs = nowNs + DEBOUNCE_MS * 1000000LL;
+
+        if (isDown && pressCallback) {
+            pressCallback();
+        } else if (!isDown && releaseCallback) {
+            releaseCallback();
+        }
+
+#if DEBUG_INPUTS
+        // Logged after the callback to keep console I/O off the trigger path
+        std::cout << "[BTN " << pin << "] edge " << (isDown ? "(PRESSED)" : "(released)")
+                  << " +" << (nowNs - edgeNs) / 1000 << "us" << std::endl;
+#endif
     }
 }
 
@@ -438,6 +574,7 @@ GPIOController::GPIOController(AudioEngine& engine, ShutdownCallback shutdownCb)
     , running(false)
     , currentBank(Bank::A)
     , shiftPressed(false)
+    , lowLatency(false)
     , secretMode(SecretMode::None)
     // secretModePreset and lastPitchEnvPosition are initialized via brace-init in header
 {
@@ -448,7 +585,11 @@ GPIOController::~GPIOController() {
 }
 
 bool GPIOController::initGPIO() {
-    return initPlatformGPIO();
+    return initPlatformGPIO(lowLatency ? GPIO::TRIGGER_BTN : -1);
+}
+
+float GPIOController::getTriggerDetectLatencyMs() const {
+    return MomentarySwitch::detectLatencyMs(lowLatency);
 }
 
 void GPIOController::cleanupGPIO() {
@@ -488,6 +629,7 @@ void GPIOController::start() {
             [this]() { onTriggerPress(); },
             [this]() { onTriggerRelease(); }
         );
+        buttons[0]->setLeadingEdge(lowLatency);
         buttons[0]->start();
         std::cout << "  ✓ trigger button initialized (GPIO " << GPIO::TRIGGER_BTN << ")" << std::endl;
         
@@ -538,7 +680,8 @@ void GPIOController::start() {
         }
     }
     
-    // Apply initial parameters (Auto Wail preset)
+    // Apply initial parameters (Auto Wail preset) as a single snapshot
+    engine.beginParameterBatch();
     engine.setVolume(params.volume);
     engine.setLfoDepth(params.lfoDepth);        // Filter modulation depth
     engine.setLfoPitchDepth(0.5f);              // Auto Wail pitch modulation (wee-woo)
@@ -551,6 +694,7 @@ void GPIOController::start() {
     engine.setDelayTime(params.delayTime);
     engine.setReverbSize(params.reverbSize);
     engine.setWaveform(params.oscWaveform);
+    engine.endParameterBatch();
 
     std::cout << "  Initial LFO: depth=" << params.lfoDepth << ", rate=" << params.lfoRate << "Hz" << std::endl;
     
@@ -613,6 +757,14 @@ void GPIOController::handleEncoder(int encoderIndex, int direction) {
 
     ParamId paramId = (bank == Bank::A) ? bankAParams[encoderIndex] : bankBParams[encoderIndex];
 
+    // Preset modes: the waveform encoder morphs between presets instead
+    SecretMode mode = secretMode.load();
+    if (paramId == ParamId::OscWaveform && (mode == SecretMode::NJD || mode == SecretMode::UFO)) {
+        paramId = ParamId::Morph;
+    } else if (paramId == ParamId::OscWaveform && engine.getSampleCount() > 0) {
+        paramId = ParamId::SamplePitch;
+    }
+
     float step;
     float newValue = 0.0f;
     const char* paramName = "";
@@ -707,6 +859,21 @@ void GPIOController::handleEncoder(int encoderIndex, int direction) {
             newValue = static_cast<float>(params.oscWaveform);
             paramName = "osc_waveform";
             break;
+
+        case ParamId::Morph:
+            step = 0.05f * direction;
+            params.morph = clamp(params.morph + step, 0.0f, 1.0f);
+            engine.setMorphPosition(params.morph);
+            newValue = params.morph;
+            paramName = "morph";
+            break;
+
+        case ParamId::SamplePitch:
+            params.samplePitch = clamp(params.samplePitch + direction, -24.0f, 24.0f);
+            engine.setSamplePitch(params.samplePitch);
+            newValue = params.samplePitch;
+            paramName = "sample_pitch";
+            break;
     }
 
     const char* bankName = (bank == Bank::A) ? "A" : "B";
@@ -717,12 +884,30 @@ void GPIOController::onTriggerPress() {
     SecretMode currentMode = secretMode.load();
 
     if (currentMode == SecretMode::MP3) {
-        // In MP3 mode, trigger starts playback
-        std::cout << "Trigger: STARTING MP3 PLAYBACK" << std::endl;
-        engine.startMP3Playback();
+        int cues = engine.getMP3CueCount();
+        if (cues > 0) {
+            // A file with cue points steps through them, one per press
+            int cue = mp3Cue.load() % cues;
+            mp3Cue.store(cue + 1);
+            std::cout << "Trigger: MP3 CUE " << (cue + 1) << "/" << cues << std::endl;
+            engine.startMP3Cue(cue);
+        } else {
+            // In MP3 mode, trigger starts playback
+            std::cout << "Trigger: STARTING MP3 PLAYBACK" << std::endl;
+            engine.startMP3Playback();
+        }
+    } else if (shiftPressed.load() && engine.getSampleCount() > 0) {
+        // Shift+trigger fires the one-shots in turn, one per press
+        int sample = nextSample.load() % engine.getSampleCount();
+        nextSample.store(sample + 1);
+        triggerFiredSample.store(true);
+        engine.triggerSample(sample, buttons[0]->getLastEdgeNs());
+        std::cout << "Trigger: SAMPLE " << (sample + 1) << "/" << engine.getSampleCount() << std::endl;
     } else {
+        // Engine first: the edge timestamp places the note, logging can wait
+        triggerFiredSample.store(false);
+        engine.trigger(buttons[0]->getLastEdgeNs());
         std::cout << "Trigger: PRESSED" << std::endl;
-        engine.trigger();
     }
 }
 
@@ -732,9 +917,11 @@ void GPIOController::onTriggerRelease() {
     if (currentMode == SecretMode::MP3) {
         // In MP3 mode, release doesn't do anything (one-shot playback)
         // MP3 will auto-exit when finished
+    } else if (triggerFiredSample.exchange(false)) {
+        // One-shots play out on their own
     } else {
+        engine.release(buttons[0]->getLastEdgeNs());
         std::cout << "Trigger: RELEASED" << std::endl;
-        engine.release();
     }
 }
 
@@ -819,6 +1006,8 @@ void GPIOController::onShiftPress() {
             int fileCount = engine.getMP3FileCount();
             int nextIndex = (currentIndex + 1) % fileCount;
             engine.selectMP3File(nextIndex);
+            mp3Cue.store(0);
+            mp3File.store(nextIndex);
 
             // Update LED color for new file
             if (ledController) {
@@ -1042,13 +1231,18 @@ void GPIOController::activateSecretMode(SecretMode mode) {
         }
 
         if (loaded) {
+            mp3Cue.store(0);
+            mp3File.store(engine.getCurrentMP3Index());
             int fileCount = engine.getMP3FileCount();
             std::string fileName = engine.getCurrentMP3FileName();
             std::cout << "║  Loaded " << fileCount << " MP3 file(s)" << std::string(34 - std::to_string(fileCount).length(), ' ') << "║" << std::endl;
             std::cout << "║  Current: " << fileName << std::string(45 - fileName.length(), ' ') << "║" << std::endl;
             std::cout << "║  From: " << mp3Dir << std::string(51 - mp3Dir.length(), ' ') << "║" << std::endl;
+            if (engine.isMP3Loading()) {
+                std::cout << "║  More files loading in the background                    ║" << std::endl;
+            }
             std::cout << "║  Press TRIGGER to play                                   ║" << std::endl;
-            if (fileCount > 1) {
+            if (fileCount > 1 || engine.isMP3Loading()) {
                 std::cout << "║  Press SHIFT to cycle files                              ║" << std::endl;
             }
         } else {
@@ -1109,31 +1303,27 @@ void GPIOController::exitSecretMode() {
     // Only restore default parameters when exiting NJD or UFO modes
     // (PitchDelay mode doesn't change parameters, just behavior)
     if (currentMode == SecretMode::NJD || currentMode == SecretMode::UFO) {
-        // Restore default parameters (Auto Wail preset)
+        // Restore the normal-mode sound (Auto Wail) as one snapshot; the
+        // engine crossfades into it as it does into a preset
+        const Preset& preset = PresetBank::normalMode();
         params.volume = 0.6f;
-        params.lfoDepth = 0.5f;      // LFO filter modulation depth
-        params.lfoRate = 2.0f;       // 2 Hz - wee-woo every 0.5 seconds
-        params.baseFreq = 440.0f;    // A4 - standard siren pitch
-        params.delayFeedback = 0.55f;// Spacey dub echoes
-        params.delayTime = 0.375f;   // Dotted eighth - classic dub
-        params.reverbMix = 0.4f;     // Wet for atmosphere
-        params.reverbSize = 0.7f;    // Large dub space
-        params.release = 0.5f;       // Medium release
-        params.oscWaveform = 1;      // Square for classic siren sound
-
-        // Apply restored parameters (Auto Wail preset)
+        engine.beginParameterBatch();
+        engine.applyPreset(preset);
+        engine.clearMorph();
         engine.setVolume(params.volume);
-        engine.setLfoDepth(params.lfoDepth);        // Filter modulation depth
-        engine.setLfoPitchDepth(0.5f);              // Auto Wail pitch modulation (wee-woo)
-        engine.setLfoRate(params.lfoRate);
-        engine.setLfoWaveform(Waveform::Triangle);  // Smooth pitch transitions
-        engine.setFrequency(params.baseFreq);
-        engine.setDelayFeedback(params.delayFeedback);
-        engine.setDelayTime(params.delayTime);
-        engine.setReverbMix(params.reverbMix);
-        engine.setReverbSize(params.reverbSize);
-        engine.setReleaseTime(params.release);
-        engine.setWaveform(params.oscWaveform);
+        engine.endParameterBatch();
+        params.morph = 0.0f;
+
+        // Keep encoder state in step with the engine
+        params.baseFreq = preset.baseFrequency;
+        params.release = preset.releaseTime;
+        params.oscWaveform = preset.oscWaveform % 4;
+        params.delayTime = preset.delayTime;
+        params.delayFeedback = preset.delayFeedback;
+        params.reverbSize = preset.reverbSize;
+        params.reverbMix = preset.reverbMix;
+        params.lfoRate = preset.lfoRate;
+        params.lfoDepth = preset.lfoDepth;
 
         std::cout << "Parameters restored to defaults" << std::endl;
     }
@@ -1141,8 +1331,9 @@ void GPIOController::exitSecretMode() {
 
 void GPIOController::cycleSecretModePreset() {
     SecretMode currentMode = secretMode.load();
+    PresetGroup group = (currentMode == SecretMode::UFO) ? PresetGroup::UFO : PresetGroup::NJD;
 
-    int numPresets = (currentMode == SecretMode::NJD) ? 5 : 4;  // 5 NJD presets, 4 UFO presets
+    int numPresets = std::max(1, presetBank.count(group));
     int currentPreset = secretModePreset.load();
     secretModePreset.store((currentPreset + 1) % numPresets);
     
@@ -1151,143 +1342,54 @@ void GPIOController::cycleSecretModePreset() {
 
 void GPIOController::applySecretModePreset() {
     SecretMode currentMode = secretMode.load();
-    int preset = secretModePreset.load();  // Load once for consistent use throughout
-    
-    // Preset parameters: baseFreq, release, oscWaveform, delayTime, delayFeedback, reverbSize, reverbMix
-    
-    if (currentMode == SecretMode::NJD) {
-        // NJD Classic Dub Siren Presets
-        // These are inspired by the classic NJD siren sounds
-        const char* presetNames[] = {"Auto Wail", "Classic", "Alert", "Bright", "Wobble"};
-
-        switch (preset) {
-            case 0: // Auto Wail - automatic pitch-alternating siren (wee-woo-wee-woo)
-                params.baseFreq = 440.0f;     // A4 - standard siren pitch
-                params.release = 0.5f;        // Medium release
-                params.oscWaveform = 1;       // Square for classic siren sound
-                params.delayTime = 0.375f;    // Dotted eighth - classic dub
-                params.delayFeedback = 0.55f; // Spacey dub echoes
-                params.reverbSize = 0.7f;     // Large dub space
-                params.reverbMix = 0.4f;      // Wet for atmosphere
-                // Apply LFO pitch modulation for automatic wail
-                params.lfoRate = 0.35f;       // Slow swell over ~3 seconds
-                params.lfoDepth = 0.5f;       // Pitch modulation depth
-                engine.setLfoRate(params.lfoRate);
-                engine.setLfoPitchDepth(0.5f); // ±0.5 octaves for noticeable pitch swing
-                engine.setLfoWaveform(Waveform::Triangle); // Smooth pitch transitions
-                break;
-
-            case 1: // Classic NJD - the original dub siren sound
-                params.baseFreq = 587.0f;     // D5 - classic siren note
-                params.release = 0.8f;
-                params.oscWaveform = 1;       // Square for more edge
-                params.delayTime = 0.375f;    // Dotted eighth for reggae feel
-                params.delayFeedback = 0.5f;  // Classic dub echoes
-                params.reverbSize = 0.65f;    // Deep dub space
-                params.reverbMix = 0.35f;
-                params.lfoDepth = 0.0f;
-                engine.setLfoPitchDepth(0.0f);
-                break;
-
-            case 2: // Alert - emergency siren for rapid on/off triggering
-                params.baseFreq = 440.0f;     // A4 - mid-range wail
-                params.release = 0.3f;        // Short for clean toggling
-                params.oscWaveform = 1;       // Square for harsh siren sound
-                params.delayTime = 0.375f;    // Dotted eighth - classic dub
-                params.delayFeedback = 0.55f; // Spacey dub echoes
-                params.reverbSize = 0.7f;     // Large dub space
-                params.reverbMix = 0.4f;      // Wet for atmosphere
-                params.lfoDepth = 0.0f;
-                engine.setLfoPitchDepth(0.0f);
-                break;
-
-            case 3: // Bright - cutting through the mix
-                params.baseFreq = 880.0f;     // A5 - bright and piercing
-                params.release = 0.5f;
-                params.oscWaveform = 1;       // Square for edge
-                params.delayTime = 0.25f;
-                params.delayFeedback = 0.55f;
-                params.reverbSize = 0.4f;
-                params.reverbMix = 0.35f;
-                params.lfoDepth = 0.0f;
-                engine.setLfoPitchDepth(0.0f);
-                break;
-
-            case 4: // Wobble - with heavy resonance
-                params.baseFreq = 392.0f;     // G4
-                params.release = 1.0f;
-                params.oscWaveform = 2;       // Sawtooth
-                params.delayTime = 0.333f;    // Triplet feel
-                params.delayFeedback = 0.6f;
-                params.reverbSize = 0.5f;
-                params.reverbMix = 0.4f;
-                params.lfoDepth = 0.0f;
-                engine.setLfoPitchDepth(0.0f);
-                break;
-        }
+    int index = secretModePreset.load();  // Load once for consistent use throughout
 
-        std::cout << "[NJD MODE] Preset " << (preset + 1) << "/5: " 
-                  << presetNames[preset] << std::endl;
-                  
+    PresetGroup group;
+    const char* modeTag;
+    if (currentMode == SecretMode::NJD) {
+        group = PresetGroup::NJD;
+        modeTag = "[NJD MODE]";
     } else if (currentMode == SecretMode::UFO) {
-        // UFO Sci-Fi Presets
-        const char* presetNames[] = {"Laser Blast", "Flying Saucer", "Alien Signal", "Warp Drive"};
-
-        switch (preset) {
-            case 0: // Laser Blast - Star Wars style pew pew
-                params.baseFreq = 1600.0f;    // Bright, sharp
-                params.release = 0.15f;       // Very short, snappy
-                params.oscWaveform = 1;       // Square for harsh edge
-                params.delayTime = 0.03f;     // Very short for texture
-                params.delayFeedback = 0.4f;  // Moderate
-                params.reverbSize = 0.2f;     // Minimal space
-                params.reverbMix = 0.15f;     // Dry, punchy
-                break;
-
-            case 1: // Flying Saucer - classic UFO whoosh
-                params.baseFreq = 1200.0f;    // High pitch
-                params.release = 2.0f;        // Long decay
-                params.oscWaveform = 0;       // Sine for clean tone
-                params.delayTime = 0.1f;      // Short slapback
-                params.delayFeedback = 0.7f;  // Lots of repeats
-                params.reverbSize = 0.9f;     // Huge space
-                params.reverbMix = 0.5f;
-                break;
-
-            case 2: // Alien Signal - digital beeps
-                params.baseFreq = 1800.0f;    // Very high
-                params.release = 0.3f;        // Quick
-                params.oscWaveform = 1;       // Square for digital feel
-                params.delayTime = 0.05f;     // Very short
-                params.delayFeedback = 0.8f;  // Heavy feedback
-                params.reverbSize = 0.3f;
-                params.reverbMix = 0.6f;
-                break;
-
-            case 3: // Warp Drive - deep space rumble
-                params.baseFreq = 80.0f;      // Sub bass
-                params.release = 3.0f;        // Very long
-                params.oscWaveform = 2;       // Sawtooth for harmonics
-                params.delayTime = 0.75f;
-                params.delayFeedback = 0.5f;
-                params.reverbSize = 0.95f;    // Maximum space
-                params.reverbMix = 0.45f;
-                break;
-        }
+        group = PresetGroup::UFO;
+        modeTag = "[UFO MODE]";
+    } else {
+        return;
+    }
 
-        std::cout << "[UFO MODE] Preset " << (preset + 1) << "/4: "
-                  << presetNames[preset] << std::endl;
+    const Preset* preset = presetBank.find(group, index);
+    if (!preset) {
+        std::cerr << modeTag << " No preset " << (index + 1) << " in bank" << std::endl;
+        return;
     }
-    
-    // Apply all parameters to engine (delay and reverb always active)
-    engine.setFrequency(params.baseFreq);
-    engine.setReleaseTime(params.release);
-    engine.setWaveform(params.oscWaveform);
-    engine.setDelayTime(params.delayTime);
-    engine.setDelayFeedback(params.delayFeedback);
-    engine.setReverbSize(params.reverbSize);
-    engine.setReverbMix(params.reverbMix);
-    
+
+    // Morph target: the next preset in the group
+    int numPresets = presetBank.count(group);
+    const Preset* next = presetBank.find(group, (index + 1) % numPresets);
+
+    // One snapshot; the engine crossfades into it
+    engine.beginParameterBatch();
+    engine.applyPreset(*preset);
+    engine.setMorphEndpoints(*preset, *next);
+    engine.endParameterBatch();
+    params.morph = 0.0f;
+
+    // Keep encoder state in step with the engine
+    params.baseFreq = preset->baseFrequency;
+    params.release = preset->releaseTime;
+    params.oscWaveform = preset->oscWaveform % 4;
+    params.delayTime = preset->delayTime;
+    params.delayFeedback = preset->delayFeedback;
+    params.reverbSize = preset->reverbSize;
+    params.reverbMix = preset->reverbMix;
+    if (preset->flags & Preset::HAS_LFO_RATE) {
+        params.lfoRate = preset->lfoRate;
+    }
+    if (preset->flags & Preset::HAS_LFO_DEPTH) {
+        params.lfoDepth = preset->lfoDepth;
+    }
+
+    std::cout << modeTag << " Preset " << (index + 1) << "/" << numPresets << ": "
+              << std::string(preset->name, strnlen(preset->name, sizeof(preset->name))) << std::endl;
     std::cout << "  Base: " << params.baseFreq << "Hz, Release: " << params.release << "s" << std::endl;
 }
 
@@ -1305,6 +1407,18 @@ void GPIOController::checkMP3PlaybackStatus() {
         if (engine.hasMP3Finished()) {
             std::cout << "\n[MP3] Playback finished - returning to synthesis mode" << std::endl;
             exitSecretMode();
+            return;
+        }
+
+        // In chain mode the player moves on to the next file by itself
+        int index = engine.getCurrentMP3Index();
+        if (mp3File.exchange(index) != index) {
+            mp3Cue.store(0);
+            if (ledController) {
+                auto color = engine.getMP3Color();
+                ledController->setColor(color.r, color.g, color.b);
+            }
+            std::cout << "[MP3] Playing: " << engine.getCurrentMP3FileName() << std::endl;
         }
     }
 }
@@ -1346,6 +1460,12 @@ void SimulatedController::processCommand(char cmd) {
             break;
         }
         
+        case ',':
+        case '.':
+            engine.setSamplePitch(std::round(engine.getSamplePitch()) + (cmd == '.' ? 1.0f : -1.0f));
+            std::cout << "Sample pitch: " << engine.getSamplePitch() << " semitones" << std::endl;
+            break;
+
         case 's':
             std::cout << "\nStatus:" << std::endl;
             std::cout << "  Playing: " << (engine.isPlaying() ? "yes" : "no") << std::endl;
@@ -1363,6 +1483,10 @@ void SimulatedController::processCommand(char cmd) {
             break;
             
         default:
+            // 1-9 fire the loaded one-shot samples
+            if (cmd >= '1' && cmd <= '9' && cmd - '1' < engine.getSampleCount()) {
+                engine.triggerSample(cmd - '1');
+            }
             break;
     }
 }
@@ -1374,6 +1498,10 @@ void SimulatedController::printHelp() {
     std::cout << "  t - Trigger siren (toggle)" << std::endl;
     std::cout << "  p - Cycle pitch envelope mode" << std::endl;
     std::cout << "  s - Show status" << std::endl;
+    if (engine.getSampleCount() > 0) {
+        std::cout << "  1-" << std::min(engine.getSampleCount(), 9) << " - Fire one-shot sample" << std::endl;
+        std::cout << "  , . - Sample pitch down/up a semitone" << std::endl;
+    }
     std::cout << "  h - Show this help" << std::endl;
     std::cout << "  q - Quit" << std::endl;
     std::cout << std::endl;
@@ -0,0 +1,268 @@
+/**
+ * dubsiren-bench - time the DSP paths that have a variable cost
+ *
+ * Runs the one-shot sampler with every voice busy, at original pitch,
+ * varispeed and time-stretched, and reports the cost per audio block as
+ * microseconds and as a share of the block period: mean, 99th percentile
+ * and worst. The percentile is the figure to check on the Pi (the worst
+ * block also catches preemption); the time-stretch cases start all voices
+ * together, so their grain searches land in the same blocks.
+ *
+ * Then runs delay and reverb over a gated siren sweep with float and with
+ * half-precision lines (--compact-lines), timing both and reporting how
+ * far the half-precision output is from the float one.
+ *
+ * Usage:
+ *   dubsiren-bench [options] [BANK]
+ *
+ * Options:
+ *   --buffer-size SIZE   Frames per block (default: 256)
+ *   --blocks COUNT       Blocks per case (default: 4000)
+ *   --help               Show this help message
+ *
+ * Without a BANK a synthetic one (vowel-like harmonics) is used.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include "Common.h"
+#include "Audio/Sampler.h"
+#include "Audio/SampleBank.h"
+#include "DSP/Delay.h"
+#include "DSP/Reverb.h"
+
+using namespace DubSiren;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+
+// Two seconds of a gliding buzz through three formants
+bool writeSyntheticBank(const std::string& path) {
+    SampleBank::Source source;
+    source.name = "synthetic";
+    size_t frames = 2 * SampleBank::SAMPLE_RATE;
+    source.samples.resize(frames * SampleBank::CHANNELS);
+    double phase = 0.0;
+    for (size_t i = 0; i < frames; ++i) {
+        double t = static_cast<double>(i) / SampleBank::SAMPLE_RATE;
+        phase += 2.0 * M_PI * (140.0 + 20.0 * std::sin(2.0 * M_PI * 3.0 * t)) / SampleBank::SAMPLE_RATE;
+        double value = 0.0;
+        for (int h = 1; h <= 30; ++h) {
+            double f = 140.0 * h;
+            double formants = std::exp(-std::pow((f - 700.0) / 150.0, 2.0))
+                            + 0.6 * std::exp(-std::pow((f - 1200.0) / 200.0, 2.0))
+                            + 0.3 * std::exp(-std::pow((f - 2600.0) / 300.0, 2.0));
+            value += formants * std::sin(h * phase) / h;
+        }
+        source.samples[i * 2] = source.samples[i * 2 + 1] = static_cast<float>(0.4 * value);
+    }
+    return SampleBank::write(path, {source}, SampleBank::FORMAT_S16);
+}
+
+void printTimes(const char* name, std::vector<int64_t>& times, int bufferSize) {
+    double totalNs = 0.0;
+    for (int64_t t : times) {
+        totalNs += static_cast<double>(t);
+    }
+    std::sort(times.begin(), times.end());
+
+    double periodUs = 1e6 * bufferSize / SAMPLE_RATE;
+    auto report = [&](const char* label, double us) {
+        std::cout << std::setprecision(1) << std::setw(8) << us << " us " << label << " ("
+                  << std::setprecision(2) << 100.0 * us / periodUs << "%)";
+    };
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed;
+    report("mean", totalNs / times.size() / 1000.0);
+    report("p99", times[(times.size() - 1) * 99 / 100] / 1000.0);
+    report("worst", times.back() / 1000.0);
+    std::cout << std::endl;
+}
+
+struct Case {
+    const char* name;
+    float rateBase;
+    float rateSwing;   // LFO-like sweep around rateBase
+    float stretch;
+};
+
+void runCase(Sampler& sampler, const Case& c, int bufferSize, int blocks) {
+    std::vector<float> buffer(bufferSize);
+    std::vector<float> rate(bufferSize);
+
+    // Restart all voices together often enough that none runs out
+    int restartEvery = std::max(1, SAMPLE_RATE / 4 / bufferSize);
+    std::vector<int64_t> times(blocks);
+    double lfoPhase = 0.0;
+    for (int b = 0; b < blocks; ++b) {
+        for (int i = 0; i < bufferSize; ++i) {
+            rate[i] = c.rateBase + c.rateSwing * static_cast<float>(std::sin(lfoPhase));
+            lfoPhase += 2.0 * M_PI * 0.5 / SAMPLE_RATE;
+        }
+        if (b % restartEvery == 0) {
+            for (int v = 0; v < Sampler::MAX_VOICES; ++v) {
+                sampler.start(v % sampler.getSampleCount(), 0, 1.0f, c.stretch);
+            }
+        }
+
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        int64_t start = monotonicNanos();
+        sampler.mix(buffer.data(), bufferSize, 1.0f, c.rateSwing == 0.0f && c.rateBase == 1.0f ? nullptr : rate.data());
+        times[b] = monotonicNanos() - start;
+    }
+    sampler.stopAll();
+    printTimes(c.name, times, bufferSize);
+}
+
+// Delay into reverb, as on the siren path, with long dub echoes
+void runLines(LineStorage storage, const std::vector<float>& input, std::vector<float>& output,
+              int bufferSize) {
+    DelayEffect delay(SAMPLE_RATE, 2.0f, storage);
+    ReverbEffect reverb(SAMPLE_RATE, storage);
+    DelayEffect::Parameters delayParams;
+    delayParams.delayTime = 0.375f;
+    delayParams.feedback = 0.8f;
+    delayParams.dryWet = 0.5f;
+    delay.prepareParameters(delayParams);
+    delay.setParameters(delayParams);
+    ReverbEffect::Parameters reverbParams;
+    reverbParams.size = 0.9f;
+    reverbParams.wet = 0.5f;
+    reverb.prepareParameters(reverbParams);
+    reverb.setParameters(reverbParams);
+
+    int blocks = static_cast<int>(input.size()) / bufferSize;
+    output = input;
+    std::vector<int64_t> times(blocks);
+    for (int b = 0; b < blocks; ++b) {
+        float* block = output.data() + static_cast<size_t>(b) * bufferSize;
+        int64_t start = monotonicNanos();
+        delay.process(block, block, bufferSize);
+        reverb.process(block, block, bufferSize);
+        times[b] = monotonicNanos() - start;
+    }
+    printTimes(storage == LineStorage::Half ? "half-precision lines" : "float lines", times, bufferSize);
+}
+
+void compareLineStorage(int bufferSize, int blocks) {
+    // A square-wave siren sweeping 400 - 1200 Hz, on for 0.5 s in every 2 s
+    // so the echo and reverb tails are heard on their own
+    std::vector<float> input(static_cast<size_t>(blocks) * bufferSize);
+    double phase = 0.0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        double t = static_cast<double>(i) / SAMPLE_RATE;
+        phase += (800.0 + 400.0 * std::sin(2.0 * M_PI * 2.0 * t)) / SAMPLE_RATE;
+        bool gate = std::fmod(t, 2.0) < 0.5;
+        input[i] = gate ? (phase - std::floor(phase) < 0.5 ? 0.5f : -0.5f) : 0.0f;
+    }
+
+    std::cout << "\nDelay + reverb, " << bufferSize << "-frame blocks:" << std::endl;
+    std::vector<float> reference;
+    std::vector<float> compact;
+    runLines(LineStorage::Float, input, reference, bufferSize);
+    runLines(LineStorage::Half, input, compact, bufferSize);
+
+    double signal = 0.0;
+    double error = 0.0;
+    double peak = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        double diff = static_cast<double>(compact[i]) - reference[i];
+        signal += static_cast<double>(reference[i]) * reference[i];
+        error += diff * diff;
+        peak = std::max(peak, std::abs(diff));
+    }
+    std::cout << "  half-precision vs float: error " << std::setprecision(1)
+              << 10.0 * std::log10(signal / std::max(error, 1e-30)) << " dB under the signal, peak "
+              << 20.0 * std::log10(std::max(peak, 1e-15)) << " dBFS" << std::endl;
+}
+
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " [options] [BANK]\n\n";
+    std::cout << "Times the sample voice paths, and delay and reverb with float and\n";
+    std::cout << "half-precision lines, per audio block.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --buffer-size SIZE   Frames per block (default: " << DEFAULT_BUFFER_SIZE << ")\n";
+    std::cout << "  --blocks COUNT       Blocks per case (default: 4000)\n";
+    std::cout << "  --help               Show this help message\n";
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* bankPath = nullptr;
+    int bufferSize = DEFAULT_BUFFER_SIZE;
+    int blocks = 4000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc) {
+            bufferSize = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--blocks") == 0 && i + 1 < argc) {
+            blocks = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argv[i][0] != '-' && !bankPath) {
+            bankPath = argv[i];
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    Sampler sampler(SAMPLE_RATE);
+    if (bankPath) {
+        if (!sampler.loadBank(bankPath)) {
+            return 1;
+        }
+    } else {
+        std::string path = (fs::temp_directory_path() / "dubsiren-bench.bank").string();
+        bool loaded = writeSyntheticBank(path) && sampler.loadBank(path);
+        std::error_code ec;
+        fs::remove(path, ec);
+        if (!loaded) {
+            std::cerr << "Cannot create the synthetic sample bank" << std::endl;
+            return 1;
+        }
+    }
+    if (sampler.getSampleCount() == 0) {
+        std::cerr << "No samples in the bank" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\nSampler, " << Sampler::MAX_VOICES << " voices, " << bufferSize << "-frame blocks ("
+              << std::fixed << std::setprecision(2) << 1000.0 * bufferSize / SAMPLE_RATE << " ms):" << std::endl;
+
+    const Case cases[] = {
+        {"original pitch", 1.0f, 0.0f, 1.0f},
+        {"varispeed 0.5x-0.9x", 0.7f, 0.2f, 1.0f},
+        {"varispeed 1.1x-2.9x (band-limited)", 2.0f, 0.9f, 1.0f},
+        {"time-stretch 2x", 1.0f, 0.0f, 2.0f},
+        {"time-stretch 0.5x", 1.0f, 0.0f, 0.5f},
+        {"time-stretch 2x + varispeed 1.1x-2.9x", 2.0f, 0.9f, 2.0f},
+    };
+    for (const Case& c : cases) {
+        runCase(sampler, c, bufferSize, blocks);
+    }
+
+    // Coarse pass, plus the nominal lag and the 7 around the best
+    int lags = 2 * Sampler::STRETCH_SEARCH / 4 + 1 + 8;
+    std::cout << "\nTime-stretch search bound: " << Sampler::MAX_SEARCHES_PER_BLOCK
+              << " per block, each at most " << lags << " lags x "
+              << Sampler::STRETCH_WINDOW << " frames" << std::endl;
+
+    compareLineStorage(bufferSize, blocks);
+    return 0;
+}
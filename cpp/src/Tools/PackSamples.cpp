@@ -0,0 +1,291 @@
+/**
+ * dubsiren-pack - build a prebuilt sample bank
+ *
+ * Decodes every MP3/WAV file in a directory, one per core, converts them to
+ * 48kHz stereo and writes a SampleBank that the player maps instead of
+ * decoding.
+ *
+ * Usage:
+ *   dubsiren-pack [options] DIRECTORY
+ *
+ * Options:
+ *   --output FILE   Bank to write (default: DIRECTORY/samples.bank)
+ *   --float         Store 32-bit float instead of dithered 16-bit PCM
+ *   --help          Show this help message
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+
+#include "Audio/AudioFilePlayer.h"
+#include "Audio/SampleBank.h"
+#include "DSP/Resampler.h"
+
+// Declarations only; the decoder is compiled into AudioFilePlayer.cpp
+#define MINIMP3_FLOAT_OUTPUT
+#include "../../external/minimp3_ex.h"
+
+using namespace DubSiren;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Decoded {
+    std::vector<float> samples;  // Interleaved
+    int sampleRate = 0;
+    int channels = 0;
+};
+
+bool decodeMP3(const std::string& path, Decoded& out) {
+    mp3dec_t mp3d;
+    mp3dec_file_info_t info;
+    std::memset(&info, 0, sizeof(info));
+
+    if (mp3dec_load(&mp3d, path.c_str(), &info, nullptr, nullptr) != 0 || !info.buffer || info.samples == 0) {
+        free(info.buffer);
+        return false;
+    }
+
+    out.samples.assign(info.buffer, info.buffer + info.samples);
+    out.sampleRate = info.hz;
+    out.channels = info.channels;
+    free(info.buffer);
+    return true;
+}
+
+uint32_t readLE(const unsigned char* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// PCM 16/24/32-bit or 32-bit float, plain or WAVE_FORMAT_EXTENSIBLE
+bool decodeWAV(const std::string& path, Decoded& out) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 || std::memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    int formatTag = 0;
+    int bits = 0;
+    const unsigned char* pcm = nullptr;
+    size_t pcmBytes = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        const unsigned char* chunk = &data[pos];
+        size_t size = readLE(chunk + 4, 4);
+        size_t available = std::min(size, data.size() - pos - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            formatTag = static_cast<int>(readLE(chunk + 8, 2));
+            out.channels = static_cast<int>(readLE(chunk + 10, 2));
+            out.sampleRate = static_cast<int>(readLE(chunk + 12, 4));
+            bits = static_cast<int>(readLE(chunk + 22, 2));
+            if (formatTag == 0xFFFE && available >= 26) {
+                formatTag = static_cast<int>(readLE(chunk + 32, 2));  // SubFormat GUID
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            pcm = chunk + 8;
+            pcmBytes = available;
+        }
+
+        pos += 8 + size + (size & 1);
+    }
+
+    bool supported = (formatTag == 1 && (bits == 16 || bits == 24 || bits == 32))
+                  || (formatTag == 3 && bits == 32);
+    if (!pcm || !supported || out.channels < 1 || out.channels > 2 || out.sampleRate <= 0) {
+        return false;
+    }
+
+    int bytes = bits / 8;
+    size_t count = pcmBytes / bytes / out.channels * out.channels;
+    out.samples.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* p = pcm + i * bytes;
+        uint32_t raw = readLE(p, bytes);
+        if (formatTag == 3) {
+            std::memcpy(&out.samples[i], &raw, sizeof(float));
+        } else {
+            // Left-justify, then scale the signed 32-bit value
+            int32_t value = static_cast<int32_t>(raw << (32 - bits));
+            out.samples[i] = static_cast<float>(value) * (1.0f / 2147483648.0f);
+        }
+    }
+    return true;
+}
+
+// One file's result, filled in by whichever worker converts it
+struct Slot {
+    bool ok = false;
+    Decoded decoded;              // Source format (samples released after conversion)
+    std::vector<float> samples;   // Bank format
+};
+
+bool isMP3(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".mp3";
+}
+
+// Interleaved stereo at the bank rate
+std::vector<float> toBankFormat(const Decoded& decoded) {
+    size_t frames = decoded.samples.size() / decoded.channels;
+    std::vector<float> stereo;
+    if (decoded.channels == 1) {
+        stereo.resize(frames * 2);
+        for (size_t i = 0; i < frames; ++i) {
+            stereo[i * 2] = stereo[i * 2 + 1] = decoded.samples[i];
+        }
+    } else {
+        stereo = decoded.samples;
+    }
+
+    if (decoded.sampleRate == SampleBank::SAMPLE_RATE) {
+        return stereo;
+    }
+    return PolyphaseResampler::convert(stereo.data(), frames, SampleBank::CHANNELS,
+                                       decoded.sampleRate, SampleBank::SAMPLE_RATE);
+}
+
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " [options] DIRECTORY\n\n";
+    std::cout << "Packs the MP3/WAV files in DIRECTORY into a sample bank.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --output FILE   Bank to write (default: DIRECTORY/" << AudioFilePlayer::BANK_FILE << ")\n";
+    std::cout << "  --float         Store 32-bit float instead of dithered 16-bit PCM\n";
+    std::cout << "  --help          Show this help message\n";
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* directory = nullptr;
+    std::string output;
+    uint16_t format = SampleBank::FORMAT_S16;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (strcmp(argv[i], "--float") == 0) {
+            format = SampleBank::FORMAT_FLOAT;
+        }
+        else if (argv[i][0] != '-' && !directory) {
+            directory = argv[i];
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!directory) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec)) {
+        std::cerr << "Directory does not exist: " << directory << std::endl;
+        return 1;
+    }
+
+    if (output.empty()) {
+        output = (fs::path(directory) / AudioFilePlayer::BANK_FILE).string();
+    }
+
+    // Same order as the player uses for a directory of MP3s
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file()) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == ".mp3" || extension == ".wav") {
+                files.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    // Decode and resample on every core; files are independent
+    std::vector<Slot> slots(files.size());
+    std::atomic<size_t> nextFile{0};
+    size_t workers = std::min<size_t>(files.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&] {
+            for (size_t i = nextFile.fetch_add(1); i < files.size(); i = nextFile.fetch_add(1)) {
+                Slot& slot = slots[i];
+                slot.ok = isMP3(files[i]) ? decodeMP3(files[i].string(), slot.decoded)
+                                          : decodeWAV(files[i].string(), slot.decoded);
+                if (slot.ok) {
+                    slot.samples = toBankFormat(slot.decoded);
+                    std::vector<float>().swap(slot.decoded.samples);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : pool) {
+        worker.join();
+    }
+
+    // Collected in directory order, so the bank is the same however the
+    // work was scheduled
+    std::vector<SampleBank::Source> sources;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const fs::path& path = files[i];
+        Slot& slot = slots[i];
+        if (!slot.ok) {
+            std::cerr << "Skipping " << path.filename().string() << ": cannot decode" << std::endl;
+            continue;
+        }
+
+        SampleBank::Source source;
+        source.name = path.filename().string();
+        if (source.name.size() >= sizeof(SampleBankEntry::name)) {
+            std::cerr << "Warning: name truncated to " << sizeof(SampleBankEntry::name) - 1
+                      << " characters: " << source.name << std::endl;
+        }
+
+        AudioFilePlayer::Color color = AudioFilePlayer::defaultColor(static_cast<int>(sources.size()));
+        source.color[0] = color.r;
+        source.color[1] = color.g;
+        source.color[2] = color.b;
+        source.samples = std::move(slot.samples);
+
+        std::cout << source.name << ": " << slot.decoded.sampleRate << " Hz "
+                  << (slot.decoded.channels == 1 ? "mono" : "stereo") << ", "
+                  << source.samples.size() / SampleBank::CHANNELS << " frames" << std::endl;
+        sources.push_back(std::move(source));
+    }
+
+    if (sources.empty()) {
+        std::cerr << "No MP3 or WAV files found in directory: " << directory << std::endl;
+        return 1;
+    }
+
+    if (!SampleBank::write(output, sources, format)) {
+        std::cerr << "Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << sources.size() << " sample(s) to " << output
+              << " (" << fs::file_size(output, ec) / 1024 << " KiB)" << std::endl;
+    return 0;
+}
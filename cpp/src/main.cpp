@@ -11,8 +11,25 @@
  *   --sample-rate RATE    Audio sample rate (default: 48000)
  *   --buffer-size SIZE    Audio buffer size (default: 256)
  *   --device DEVICE       ALSA audio device (default: "default")
+ *   --no-mmap            Use snd_pcm_writei instead of mmap access
+ *   --format FORMAT      Force s16, s24 or s32 output (default: widest supported)
+ *   --adaptive-latency   Start at 64x2 periods and adapt to observed underruns
+ *   --low-latency        64-frame periods x2, edge-triggered leading-edge trigger button
+ *   --duplex             Full-duplex FX mode: line input through delay and reverb
+ *   --capture-device DEV ALSA capture device for --duplex (default: playback device)
  *   --simulate           Run in simulation mode (no hardware)
+ *   --sim-realtime       Run the simulated audio clock at SCHED_FIFO
+ *   --duration SECONDS   Exit after SECONDS (e.g. for timing runs in CI)
  *   --interactive        Run in interactive mode (keyboard control)
+ *   --record PATH        Record the output to a WAV file (or into directory PATH)
+ *   --compact-samples    Buffer MP3 playback as 16-bit PCM (half the locked memory)
+ *   --compact-lines      Hold delay and reverb lines as half-precision floats (half the cache footprint)
+ *   --chain-files        Follow each MP3 file that ends with the next one, gapless
+ *   --chain-crossfade MS Crossfade chained MP3 files over MS milliseconds (implies --chain-files)
+ *   --samples FILE       Load one-shot samples from a sample bank (keys 1-9 in --interactive)
+ *   --sample-stretch X   Time-stretch one-shots by X (0.25-4), or 'delay' to fit the delay time
+ *   --presets FILE       Load NJD/UFO presets from a binary bank file
+ *   --save-presets FILE  Write the built-in preset bank to FILE and exit
  *   --help               Show this help message
  */
 
@@ -21,6 +38,7 @@
 #include <atomic>
 #include <cstring>
 #include <cfenv>
+#include <iomanip>
 
 #if defined(__x86_64__) || defined(__i386__)
 #include <xmmintrin.h>
@@ -33,6 +51,7 @@
 #include "Common.h"
 #include "Audio/AudioEngine.h"
 #include "Audio/AudioOutput.h"
+#include "Audio/AudioRecorder.h"
 #include "Hardware/GPIOController.h"
 
 using namespace DubSiren;
@@ -76,14 +95,50 @@ void printBanner() {
     std::cout << "\n";
 }
 
+/**
+ * Print the worst-case trigger-to-DAC latency for the configured profile.
+ * The ALSA figures are the requested ones; the [ALSA] line shows what the
+ * driver granted.
+ */
+void printLatencyBudget(int sampleRate, int periodFrames, int periods, float inputMs) {
+    float periodMs = 1000.0f * periodFrames / sampleRate;
+    float eventMs = periodMs;            // Events replay one block later, sample-accurate
+    float queueMs = periodMs * periods;  // Ring buffer ahead of the DAC
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Latency budget (worst case, trigger -> DAC):" << std::endl;
+    std::cout << "  Button detect:    " << inputMs << " ms" << std::endl;
+    std::cout << "  Event alignment:  " << eventMs << " ms" << std::endl;
+    std::cout << "  ALSA ring:        " << queueMs << " ms (" << periods << " x " << periodFrames << " frames)" << std::endl;
+    std::cout << "  Total:            " << (inputMs + eventMs + queueMs) << " ms" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
 void printHelp(const char* programName) {
     std::cout << "Usage: " << programName << " [options]\n\n";
     std::cout << "Options:\n";
     std::cout << "  --sample-rate RATE    Audio sample rate (default: 48000)\n";
     std::cout << "  --buffer-size SIZE    Audio buffer size (default: 256)\n";
     std::cout << "  --device DEVICE       ALSA audio device (default: \"default\")\n";
+    std::cout << "  --no-mmap            Use snd_pcm_writei instead of mmap access\n";
+    std::cout << "  --format FORMAT      Force s16, s24 or s32 output (default: widest supported)\n";
+    std::cout << "  --adaptive-latency   Start at 64x2 periods and adapt to observed underruns\n";
+    std::cout << "  --low-latency        64-frame periods x2, edge-triggered leading-edge trigger button\n";
+    std::cout << "  --duplex             Full-duplex FX mode: line input through delay and reverb\n";
+    std::cout << "  --capture-device DEV ALSA capture device for --duplex (default: playback device)\n";
     std::cout << "  --simulate           Run in simulation mode (no hardware)\n";
+    std::cout << "  --sim-realtime       Run the simulated audio clock at SCHED_FIFO\n";
+    std::cout << "  --duration SECONDS   Exit after SECONDS (e.g. for timing runs in CI)\n";
     std::cout << "  --interactive        Run in interactive mode (keyboard control)\n";
+    std::cout << "  --record PATH        Record the output to a WAV file (or into directory PATH)\n";
+    std::cout << "  --compact-samples    Buffer MP3 playback as 16-bit PCM (half the locked memory)\n";
+    std::cout << "  --compact-lines      Hold delay and reverb lines as half-precision floats (half the cache footprint)\n";
+    std::cout << "  --chain-files        Follow each MP3 file that ends with the next one, gapless\n";
+    std::cout << "  --chain-crossfade MS Crossfade chained MP3 files over MS milliseconds (implies --chain-files)\n";
+    std::cout << "  --samples FILE       Load one-shot samples from a sample bank (keys 1-9 in --interactive)\n";
+    std::cout << "  --sample-stretch X   Time-stretch one-shots by X (0.25-4), or 'delay' to fit the delay time\n";
+    std::cout << "  --presets FILE       Load NJD/UFO presets from a binary bank file\n";
+    std::cout << "  --save-presets FILE  Write the built-in preset bank to FILE and exit\n";
     std::cout << "  --help               Show this help message\n";
     std::cout << "\n";
 }
@@ -93,8 +148,26 @@ int main(int argc, char* argv[]) {
     int sampleRate = DEFAULT_SAMPLE_RATE;
     int bufferSize = DEFAULT_BUFFER_SIZE;
     const char* device = nullptr;
+    bool useMmap = true;
+    const char* format = nullptr;
+    bool adaptiveLatency = false;
+    bool lowLatency = false;
+    bool duplex = false;
+    const char* captureDevice = nullptr;
+    bool bufferSizeSet = false;
+    int periods = 3;
     bool simulate = false;
+    bool simRealtime = false;
+    double duration = 0.0;
     bool interactive = false;
+    const char* presetFile = nullptr;
+    const char* recordPath = nullptr;
+    bool compactSamples = false;
+    bool compactLines = false;
+    bool chainFiles = false;
+    float chainCrossfadeMs = 0.0f;
+    const char* samplesPath = nullptr;
+    const char* sampleStretch = nullptr;
     
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -107,22 +180,85 @@ int main(int argc, char* argv[]) {
         }
         else if (strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc) {
             bufferSize = std::atoi(argv[++i]);
+            bufferSizeSet = true;
         }
         else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
             device = argv[++i];
         }
+        else if (strcmp(argv[i], "--no-mmap") == 0) {
+            useMmap = false;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
+        }
+        else if (strcmp(argv[i], "--adaptive-latency") == 0) {
+            adaptiveLatency = true;
+        }
+        else if (strcmp(argv[i], "--low-latency") == 0) {
+            lowLatency = true;
+        }
+        else if (strcmp(argv[i], "--duplex") == 0) {
+            duplex = true;
+        }
+        else if (strcmp(argv[i], "--capture-device") == 0 && i + 1 < argc) {
+            captureDevice = argv[++i];
+        }
         else if (strcmp(argv[i], "--simulate") == 0) {
             simulate = true;
         }
+        else if (strcmp(argv[i], "--sim-realtime") == 0) {
+            simRealtime = true;
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration = std::atof(argv[++i]);
+        }
         else if (strcmp(argv[i], "--interactive") == 0) {
             interactive = true;
         }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--compact-samples") == 0) {
+            compactSamples = true;
+        }
+        else if (strcmp(argv[i], "--compact-lines") == 0) {
+            compactLines = true;
+        }
+        else if (strcmp(argv[i], "--chain-files") == 0) {
+            chainFiles = true;
+        }
+        else if (strcmp(argv[i], "--chain-crossfade") == 0 && i + 1 < argc) {
+            chainFiles = true;
+            chainCrossfadeMs = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samplesPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--sample-stretch") == 0 && i + 1 < argc) {
+            sampleStretch = argv[++i];
+        }
+        else if (strcmp(argv[i], "--presets") == 0 && i + 1 < argc) {
+            presetFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--save-presets") == 0 && i + 1 < argc) {
+            PresetBank bank;
+            return bank.saveToFile(argv[++i]) ? 0 : 1;
+        }
         else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             printHelp(argv[0]);
             return 1;
         }
     }
+
+    // Low-latency profile: one small period of slack, unless the buffer
+    // size was chosen explicitly
+    if (lowLatency) {
+        if (!bufferSizeSet) {
+            bufferSize = LOW_LATENCY_BUFFER_SIZE;
+        }
+        periods = 2;
+    }
     
     // Setup signal handlers
     std::signal(SIGINT, signalHandler);
@@ -151,19 +287,66 @@ int main(int argc, char* argv[]) {
     
     // Create audio engine
     AudioEngine engine(sampleRate, bufferSize);
+    if (compactSamples) {
+        engine.setMP3SampleStorage(AudioFilePlayer::SampleStorage::Int16);
+    }
+    if (compactLines) {
+        engine.setDelayLineStorage(LineStorage::Half);
+    }
+    if (chainFiles) {
+        engine.setMP3Chain(true, chainCrossfadeMs / 1000.0f);
+    }
+    if (samplesPath && !engine.loadSamples(samplesPath)) {
+        return 1;
+    }
+    if (sampleStretch) {
+        if (strcmp(sampleStretch, "delay") == 0) {
+            engine.setSampleStretchToDelay(true);
+        } else {
+            engine.setSampleStretch(static_cast<float>(std::atof(sampleStretch)));
+        }
+    }
     
+    // Optional recorder, fed by whichever output runs
+    std::unique_ptr<AudioRecorder> recorder;
+    if (recordPath) {
+        recorder = std::make_unique<AudioRecorder>(sampleRate, DEFAULT_CHANNELS);
+        if (!recorder->start(recordPath)) {
+            return 1;
+        }
+    }
+
     // Create audio output
     std::unique_ptr<AudioOutput> audioOutput;
     std::unique_ptr<SimulatedAudioOutput> simAudioOutput;
     
     if (simulate) {
-        simAudioOutput = std::make_unique<SimulatedAudioOutput>(engine, bufferSize);
+        simAudioOutput = std::make_unique<SimulatedAudioOutput>(engine, sampleRate, bufferSize);
+        simAudioOutput->setRealtimeEnabled(simRealtime);
+        simAudioOutput->setRecorder(recorder.get());
         if (!simAudioOutput->start()) {
             std::cerr << "Failed to start simulated audio output" << std::endl;
             return 1;
         }
     } else {
         audioOutput = std::make_unique<AudioOutput>(engine, sampleRate, bufferSize, DEFAULT_CHANNELS, device);
+        audioOutput->setMmapEnabled(useMmap);
+        audioOutput->setAdaptiveLatency(adaptiveLatency);
+        audioOutput->setPeriodCount(periods);
+        audioOutput->setRecorder(recorder.get());
+        audioOutput->setDuplex(duplex, captureDevice);
+        if (format) {
+            if (strcmp(format, "s16") == 0) {
+                audioOutput->setSampleFormat(SampleFormat::S16);
+            } else if (strcmp(format, "s24") == 0) {
+                audioOutput->setSampleFormat(SampleFormat::S24);
+            } else if (strcmp(format, "s32") == 0) {
+                audioOutput->setSampleFormat(SampleFormat::S32);
+            } else {
+                std::cerr << "Unknown format: " << format << " (use s16, s24 or s32)" << std::endl;
+                return 1;
+            }
+        }
         if (!audioOutput->start()) {
             std::cerr << "Failed to start audio output" << std::endl;
             std::cerr << "\nTroubleshooting:" << std::endl;
@@ -185,7 +368,19 @@ int main(int argc, char* argv[]) {
         gpioController = std::make_unique<GPIOController>(engine, [&]() {
             g_running.store(false);
         });
+        if (presetFile && !gpioController->loadPresetBank(presetFile)) {
+            std::cerr << "Using built-in presets" << std::endl;
+        }
+        gpioController->setLowLatency(lowLatency);
         gpioController->start();
+
+        // Adaptive mode starts at its lowest setting and reports changes
+        std::cout << "\n";
+        if (adaptiveLatency) {
+            printLatencyBudget(sampleRate, std::min(bufferSize, LOW_LATENCY_BUFFER_SIZE), 2, gpioController->getTriggerDetectLatencyMs());
+        } else {
+            printLatencyBudget(sampleRate, bufferSize, periods, gpioController->getTriggerDetectLatencyMs());
+        }
     }
     
     std::cout << "\n✓ Dub Siren is running!" << std::endl;
@@ -210,9 +405,15 @@ int main(int argc, char* argv[]) {
     } else {
         std::cout << "Press Ctrl+C to exit" << std::endl;
 
+        auto startTime = std::chrono::steady_clock::now();
         while (g_running.load()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
+            if (duration > 0.0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() >= duration) {
+                g_running.store(false);
+            }
+
             // Check MP3 playback status for auto-exit
             if (gpioController) {
                 gpioController->checkMP3PlaybackStatus();
@@ -236,6 +437,9 @@ int main(int argc, char* argv[]) {
     if (simAudioOutput) {
         simAudioOutput->stop();
     }
+    if (recorder) {
+        recorder->stop();
+    }
     
     std::cout << "Goodbye!" << std::endl;
     